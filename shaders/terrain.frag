@@ -6,11 +6,20 @@ in float Height;
 
 out vec4 FragColor;
 
-uniform vec3 uLightDir = normalize(vec3(0.5, 1.0, 0.3));
+// Per-frame constants, shared by every program through one uniform
+// buffer. Keep in sync with FrameUniforms in render/renderer.h.
+layout(std140) uniform FrameUniforms {
+    mat4 uView;
+    mat4 uProj;
+    mat4 uViewProj;
+    vec4 uCameraPos;
+    vec4 uLightDir;         // normalized
+    vec4 uFrameParams;      // x: time in seconds
+};
+
 uniform float uWaterLevel = 0.0;        // Y-coordinate of water surface
 uniform vec3 uWaterColor = vec3(0.0, 0.3, 0.6); // blue water
 uniform float uWaterOpacity = 0.9;      // 0 = fully transparent, 1 = opaque
-uniform float uTime = 0.0; // for wave animation
 
 vec3 getTerrainColor(float h) {
     if (h < -30) return vec3(0.0, 0.0, 0.6);      // deep water
@@ -22,7 +31,7 @@ vec3 getTerrainColor(float h) {
 
 void main() {
     vec3 N = normalize(Normal);
-    float diff = max(dot(N, normalize(uLightDir)), 0.0);
+    float diff = max(dot(N, uLightDir.xyz), 0.0);
 
     // Terrain base color with lighting
     vec3 terrainColor = getTerrainColor(Height);
@@ -31,8 +40,9 @@ void main() {
     // Water effect
     if (Height < uWaterLevel) {
         // Simple wave distortion (offset color slightly by sin waves)
-        float wave = 0.02 * sin(FragPos.x * 3.0 + uTime * 2.0) 
-                   + 0.02 * cos(FragPos.z * 3.0 + uTime * 2.0);
+        float time = uFrameParams.x;
+        float wave = 0.02 * sin(FragPos.x * 3.0 + time * 2.0) 
+                   + 0.02 * cos(FragPos.z * 3.0 + time * 2.0);
         
         // Refraction: mix terrain color with water color
         float alpha = clamp(uWaterOpacity, 0.0, 1.0);
@@ -1,19 +1,65 @@
 #version 330 core
 
-layout(location = 0) in vec3 aPos;
-layout(location = 1) in vec3 aNormal;
+// Compact chunk vertex: only the height and normal are stored, the grid
+// position comes from gl_VertexID and the chunk's arena slot
+layout(location = 0) in float aHeight;      // +-32767 for [-1, 1]
+layout(location = 1) in vec2 aNormalOct;    // octahedral, +-127
 
 out vec3 FragPos;
 out vec3 Normal;
 out float Height; 
 
-uniform mat4 uView;
-uniform mat4 uProj;
+// Per-frame constants, shared by every program through one uniform
+// buffer. Keep in sync with FrameUniforms in render/renderer.h.
+layout(std140) uniform FrameUniforms {
+    mat4 uView;
+    mat4 uProj;
+    mat4 uViewProj;
+    vec4 uCameraPos;
+    vec4 uLightDir;         // normalized
+    vec4 uFrameParams;      // x: time in seconds
+};
 
-void main() {
-    FragPos = aPos;
-    Normal = aNormal;
-    Height = aPos.y;
-    gl_Position = uProj * uView * vec4(aPos, 1.0);
+// Chunks are drawn from fixed slots of one vertex buffer, so gl_VertexID
+// includes the slot's base vertex. One texel per slot: origin x and z,
+// vertices per side at the chunk's LOD, world units between them.
+uniform samplerBuffer uChunkSlots;
+uniform int uSlotVerts;
+
+uniform float uHeightScale;
+uniform float uNormalScale;     // height scale the normals were encoded at
+
+vec3 decodeOctahedral(vec2 e) {
+    vec3 n = vec3(e.x, 1.0 - abs(e.x) - abs(e.y), e.y);
+    if (n.y < 0.0) {
+        vec2 s = vec2(e.x >= 0.0 ? 1.0 : -1.0, e.y >= 0.0 ? 1.0 : -1.0);
+        n.xz = (1.0 - abs(e.yx)) * s;
+    }
+    return normalize(n);
 }
 
+void main() {
+    int slot = gl_VertexID / uSlotVerts;
+    int local = gl_VertexID - slot * uSlotVerts;
+
+    vec4 chunk = texelFetch(uChunkSlots, slot);
+    int gridVerts = int(chunk.z);
+
+    int gx = local % gridVerts;
+    int gz = local / gridVerts;
+
+    vec3 pos = vec3(
+        chunk.x + float(gx) * chunk.w,
+        aHeight / 32767.0 * uHeightScale,
+        chunk.y + float(gz) * chunk.w
+    );
+
+    // the slope scales with the height, the normal's y stays put
+    vec3 n = decodeOctahedral(aNormalOct / 127.0);
+    float k = uHeightScale / uNormalScale;
+
+    FragPos = pos;
+    Normal = normalize(vec3(n.x * k, n.y, n.z * k));
+    Height = pos.y;
+    gl_Position = uViewProj * vec4(pos, 1.0);
+}
@@ -2,17 +2,26 @@
 #include <GLFW/glfw3.h>
 
 #include "application.h"
+#include "cameraPath.h"
+#include "render/glBackend.h"
+#include "render/renderer.h"
 #include "render/shader.h"
 #include "render/camera.h"
 #include "terrain/terrainManager.h"
 #include "terrain/const.h"
+#include "util/log.h"
 
 #include "imgui.h"
 #include "backends/imgui_impl_glfw.h"
 #include "backends/imgui_impl_opengl3.h"
 
 #include <iostream>
+#include <fstream>
 #include <chrono>
+#include <thread>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
 #include <cassert>
 
 static void mouseCallback(GLFWwindow* window, double x, double y) {
@@ -37,17 +46,68 @@ static void framebufferSizeCallback(GLFWwindow*, int w, int h) {
     glViewport(0, 0, w, h);
 }
 
-Application::Application(int width, int height, const std::string& title)
-    : m_width(width), m_height(height), m_title(title) {
+// Chrome trace of the last frames, open in chrome://tracing or Perfetto
+static void exportTrace() {
+    const char* path = "terrain_trace.json";
+    if (profileExportTrace(path)) {
+        std::cout << "Trace written to " << path << std::endl;
+    }
+}
+
+// Rolling percentiles of every profiled zone
+static void drawProfilerWindow(std::vector<ProfileZoneStats>& zones, int& refresh) {
+#if TERRAIN_PROFILE
+    // sorting every zone each frame would show up in the profile itself
+    if (refresh-- <= 0) {
+        profileStats(zones);
+        refresh = 15;
+    }
+
+    ImGui::Begin("Profiler");
+    ImGui::Text("Last 120 frames, F9 writes terrain_trace.json");
+    if (ImGui::BeginTable("zones", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+        ImGui::TableSetupColumn("Zone");
+        ImGui::TableSetupColumn("Calls");
+        ImGui::TableSetupColumn("p50 ms");
+        ImGui::TableSetupColumn("p95 ms");
+        ImGui::TableSetupColumn("p99 ms");
+        ImGui::TableHeadersRow();
+        for (const auto& z : zones) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn(); ImGui::TextUnformatted(z.name.c_str());
+            ImGui::TableNextColumn(); ImGui::Text("%u", z.count);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", z.p50Ms);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", z.p95Ms);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", z.p99Ms);
+        }
+        ImGui::EndTable();
+    }
+    ImGui::End();
+#else
+    (void)zones;
+    (void)refresh;
+#endif
+}
+
+Application::Application(const AppOptions& options, int width, int height, const std::string& title)
+    : m_options(options), m_width(width), m_height(height), m_title(title) {
     initWindow();
     initOpenGL();
-    setupCallbacks();
+    if (!m_options.headless) setupCallbacks();
 }
 
 Application::~Application() {
-    ImGui_ImplOpenGL3_Shutdown();
-    ImGui_ImplGlfw_Shutdown();
-    ImGui::DestroyContext();
+    if (m_fbo) {
+        glDeleteFramebuffers(1, &m_fbo);
+        glDeleteRenderbuffers(1, &m_fboColor);
+        glDeleteRenderbuffers(1, &m_fboDepth);
+    }
+
+    if (!m_options.headless) {
+        ImGui_ImplOpenGL3_Shutdown();
+        ImGui_ImplGlfw_Shutdown();
+        ImGui::DestroyContext();
+    }
 
     glfwTerminate();
 }
@@ -55,6 +115,15 @@ Application::~Application() {
 void Application::initWindow() {
     glfwSetErrorCallback(glfwErrorCallback);
 
+#ifdef GLFW_PLATFORM_NULL
+    // without a display server a headless run gets an EGL context on
+    // GLFW's null platform
+    bool noDisplay = !std::getenv("DISPLAY") && !std::getenv("WAYLAND_DISPLAY");
+    if (m_options.headless && noDisplay) {
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+    }
+#endif
+
     if (!glfwInit()) {
         throw std::runtime_error("Failed to initialize GLFW");
     }
@@ -68,6 +137,15 @@ void Application::initWindow() {
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
 
+    if (m_options.headless) {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#ifdef GLFW_PLATFORM_NULL
+        if (glfwGetPlatform() == GLFW_PLATFORM_NULL) {
+            glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+        }
+#endif
+    }
+
     m_window = glfwCreateWindow(m_width, m_height, m_title.c_str(), nullptr, nullptr);
     if (!m_window) {
         glfwTerminate();
@@ -75,7 +153,7 @@ void Application::initWindow() {
     }
 
     glfwMakeContextCurrent(m_window);
-    glfwSwapInterval(1); // vsync
+    glfwSwapInterval(m_options.headless ? 0 : 1); // vsync, off when benchmarking
 }
 
 void Application::initOpenGL() {
@@ -110,21 +188,43 @@ void Application::initOpenGL() {
         nullptr
     );
 #endif
+    m_frameUniforms = std::make_unique<FrameUniformBuffer>();
     m_shader = std::make_unique<Shader>(
         "shaders/terrain.vert",
         "shaders/terrain.frag"
     );
 
-    m_terrain = std::make_unique<TerrainManager>(m_gridWidth, m_gridDepth);
+    m_terrain = std::make_unique<TerrainManager>(std::make_unique<GLBackend>());
+    m_terrain->m_params = m_options.params;
+    if (!m_options.tilePackPath.empty() && !m_terrain->openTileCache(m_options.tilePackPath)) {
+        std::cerr << "Tile cache disabled" << std::endl;
+    }
+
+    if (!m_options.demPath.empty()) {
+        auto dem = std::make_shared<DemSource>();
+        if (dem->open(m_options.demPath, m_options.dem)) {
+            std::cout << "DEM: " << m_options.demPath << " (" << dem->width()
+                      << "x" << dem->height() << " samples)" << std::endl;
+            m_terrain->setHeightmapSource(std::move(dem));
+        } else {
+            std::cerr << "DEM not loaded, showing procedural terrain" << std::endl;
+        }
+    }
 
-    float farPlane = m_terrain->m_scale * 1.5f; // leave some margin
+    // far enough to see the whole view radius, LOD keeps that affordable
+    float farPlane = float(m_terrain->viewRadius + 1) * CHUNK_SIZE * CELL_SIZE;
     m_camera = std::make_unique<Camera>(
         60.0f,
         float(m_width) / float(m_height),
-        0.1f,
-        500.0f
+        1.0f,
+        farPlane
     );
 
+    if (m_options.headless) {
+        createOffscreenTarget();
+        return;
+    }
+
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
     ImGuiIO& io = ImGui::GetIO();
@@ -138,6 +238,29 @@ void Application::initOpenGL() {
     ImGui_ImplOpenGL3_Init("#version 330");
 }
 
+// Frames go to renderbuffers the size of the window, the default
+// framebuffer of an invisible window may not be backed at all
+void Application::createOffscreenTarget() {
+    glGenRenderbuffers(1, &m_fboColor);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_fboColor);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, m_width, m_height);
+
+    glGenRenderbuffers(1, &m_fboDepth);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_fboDepth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, m_width, m_height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &m_fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_fboColor);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_fboDepth);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        throw std::runtime_error("Offscreen framebuffer incomplete");
+    }
+    glViewport(0, 0, m_width, m_height);
+}
+
 void Application::setupCallbacks() {
     glfwSetWindowUserPointer(m_window, this);
     glfwSetFramebufferSizeCallback(m_window, framebufferSizeCallback);
@@ -149,6 +272,9 @@ void Application::setupCallbacks() {
             auto app = static_cast<Application*>(glfwGetWindowUserPointer(window));
             app->toggleMouseCapture();
         }
+        if (key == GLFW_KEY_F9 && action == GLFW_PRESS) {
+            exportTrace();
+        }
     });
 
 }
@@ -163,15 +289,27 @@ void Application::toggleMouseCapture() {
 }
 
 void Application::run() {
+    if (m_options.headless) {
+        runHeadless();
+        return;
+    }
+
     using clock = std::chrono::high_resolution_clock;
     auto lastTime = clock::now();
 
+    std::vector<ProfileZoneStats> profileZones;
+    int profileRefresh = 0;
+    profileThreadName("main");
+
     while (m_running && !glfwWindowShouldClose(m_window)) {
+        PROFILE_FRAME();
+
         auto now = clock::now();
         float dt = std::chrono::duration<float>(now - lastTime).count();
         lastTime = now;
 
         glfwPollEvents();
+        m_frameTime = glfwGetTime();
 
         // Start ImGui frame
         ImGui_ImplOpenGL3_NewFrame();
@@ -180,6 +318,34 @@ void Application::run() {
 
         ImGui::Begin("Terrain Controls");
         ImGui::SliderFloat("Height Scale", &m_terrain->m_scale, 1.0f, 1000.0f);
+        ImGui::InputInt("Seed", &m_terrain->m_params.seed);
+        ImGui::SliderFloat("Noise Scale", &m_terrain->m_params.noiseScale, 0.05f, 2.0f);
+        ImGui::SliderFloat("Voronoi Mix", &m_terrain->m_params.mixRatio, 0.0f, 1.0f);
+        const ScheduleStats& sched = m_terrain->scheduleStats;
+        ImGui::Text("Build queue: %d waiting, %d in flight, %d stale",
+            sched.waiting, sched.inFlight, sched.stale);
+        ImGui::Text("Uploads: %d (%d deferred), %.2f / %.1f ms",
+            sched.uploads, sched.deferred, sched.budgetUsedMs, m_terrain->schedule.budgetMs);
+        ImGui::Text("Chunks drawn: %d, culled: %d",
+            m_terrain->stats.chunksDrawn, m_terrain->stats.chunksCulled);
+        ImGui::Text("Triangles: %lld", m_terrain->stats.trianglesDrawn);
+        const ResidencyStats& res = m_terrain->residency.stats();
+        ImGui::Text("Resident: %zu chunks, CPU %.1f MB, GPU %.1f MB",
+            res.resident, double(res.cpuBytes) / 1048576.0, double(res.gpuBytes) / 1048576.0);
+        const PrefetchStats& prefetch = m_terrain->prefetchStats;
+        ImGui::Text("Prefetch: %llu requested, %.0f%% of new chunks ready",
+            (unsigned long long)prefetch.requested, 100.0f * prefetch.hitRate());
+        ImGui::Text("Residency: %llu hits, %llu misses, %llu evictions",
+            (unsigned long long)res.hits, (unsigned long long)res.misses,
+            (unsigned long long)res.evictions);
+        TilePack::Stats cache = m_terrain->tileCacheStats();
+        ImGui::Text("Tile cache: %llu hits, %llu misses, %u/%u slots%s",
+            (unsigned long long)cache.hits, (unsigned long long)cache.misses,
+            cache.usedSlots, cache.slotCount,
+            m_terrain->tileCacheCurrent() ? "" : " (other parameters)");
+        if (cache.slotCount > 0 && ImGui::Button("Clear tile cache")) {
+            m_terrain->clearTileCache();
+        }
         ImGui::End();
 
         // Process camera input only if mouse is captured AND ImGui is not using it
@@ -196,27 +362,28 @@ void Application::run() {
             m_camera->processMouse(dx, dy);
         }
 
+        drawProfilerWindow(profileZones, profileRefresh);
+
         // Update & render
         processInput();
         update(dt);
 
-        glClearColor(0.1f, 0.1f, 0.15f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        m_shader->bind();
-        m_shader->setFloat("uTime", glfwGetTime());
-        m_shader->setMat4("uView", m_camera->view());
-        m_shader->setMat4("uProj", m_camera->projection());
-        m_shader->setVec3("uLightDir", glm::normalize(glm::vec3(0.5f,1.0f,0.3f)));
-        m_terrain->draw();
-        m_shader->unbind();
+        {
+            PROFILE_ZONE("render");
+            render();
 
-        // Render ImGui on top
-        ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            // Render ImGui on top
+            ImGui::Render();
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
 
-        glfwSwapBuffers(m_window);
+        {
+            PROFILE_ZONE("swap");
+            glfwSwapBuffers(m_window);
+        }
     }
+
+    exportTrace();
 }
 
 void Application::processInput() {
@@ -245,21 +412,129 @@ void Application::processInput() {
 }
 
 void Application::update(float dt) {
-    m_terrain->update(m_camera->position());
+    m_camera->updateVelocity(dt);
+    m_terrain->update(m_camera->position(), m_camera->front(), m_camera->velocity());
 }
 
 void Application::render() {
     glClearColor(0.1f, 0.1f, 0.15f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    m_shader->bind();
-    m_shader->setMat4("uView", m_camera->view());
-    m_shader->setMat4("uProj", m_camera->projection());
-
+    // one upload serves every program that declares FrameUniforms
+    FrameUniforms frame;
+    frame.view = m_camera->view();
+    frame.proj = m_camera->projection();
+    frame.viewProj = frame.proj * frame.view;
+    frame.cameraPos = glm::vec4(m_camera->position(), 1.0f);
     // optional: change light direction or color
-    m_shader->setVec3("uLightDir", glm::normalize(glm::vec3(0.5f,1.0f,0.3f)));
+    frame.lightDir = glm::vec4(glm::normalize(glm::vec3(0.5f, 1.0f, 0.3f)), 0.0f);
+    frame.params = glm::vec4(float(m_frameTime), 0.0f, 0.0f, 0.0f);
+    m_frameUniforms->update(frame);
 
-    m_terrain->draw();
+    m_shader->bind();
+    m_terrain->draw(*m_shader, m_camera->frustum());
     m_shader->unbind();
 }
 
+
+// Per-frame results of a headless run
+struct FrameSample {
+    double updateMs;
+    double renderMs;
+    TerrainStats stats;
+    ScheduleStats schedule;
+};
+
+// nearest rank, like the profiler overlay
+static double percentile(std::vector<double> v, double p) {
+    if (v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    size_t rank = size_t(std::ceil(p * double(v.size())));
+    return v[std::min(v.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+void Application::runHeadless() {
+    using clock = std::chrono::steady_clock;
+    auto ms = [](clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); };
+
+    CameraPath path = CameraPath::flyover();
+    if (!m_options.cameraPath.empty() && !path.load(m_options.cameraPath)) {
+        std::cerr << "Camera path not loaded, flying the default path" << std::endl;
+        path = CameraPath::flyover();
+    }
+    int frames = m_options.frames > 0 ? m_options.frames : path.lastFrame() + 1;
+
+    profileThreadName("main");
+    std::vector<FrameSample> samples;
+    samples.reserve(frames);
+
+    for (int frame = 0; frame < frames; frame++) {
+        PROFILE_FRAME();
+
+        CameraKey key = path.at(float(frame));
+        m_camera->setPose(key.position, key.yaw, key.pitch);
+        m_camera->updateVelocity(1.0f / 60.0f);
+        // a fixed 60 Hz clock keeps anything animated identical between runs
+        m_frameTime = frame / 60.0;
+
+        if (m_options.settle) {
+            auto start = clock::now();
+            m_terrain->update(m_camera->position(), m_camera->front(), m_camera->velocity());
+            while (!m_terrain->isIdle() && ms(clock::now() - start) < 10000.0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                m_terrain->update(m_camera->position(), m_camera->front(), m_camera->velocity());
+            }
+        }
+
+        FrameSample sample;
+        auto t0 = clock::now();
+        m_terrain->update(m_camera->position(), m_camera->front(), m_camera->velocity());
+        auto t1 = clock::now();
+
+        {
+            PROFILE_ZONE("render");
+            render();
+            // count the GPU work of this frame, not of the one before it
+            glFinish();
+        }
+        auto t2 = clock::now();
+
+        sample.updateMs = ms(t1 - t0);
+        sample.renderMs = ms(t2 - t1);
+        sample.stats = m_terrain->stats;
+        sample.schedule = m_terrain->scheduleStats;
+        samples.push_back(sample);
+
+        glfwPollEvents();
+    }
+
+    exportTrace();
+
+    std::ofstream csv(m_options.csvPath);
+    if (!csv) {
+        std::cerr << "[Application] failed to write " << m_options.csvPath << std::endl;
+        return;
+    }
+    csv << "frame,update_ms,render_ms,frame_ms,chunks_drawn,chunks_culled,triangles,uploads,in_flight\n";
+
+    std::vector<double> frameMs;
+    frameMs.reserve(samples.size());
+    double total = 0.0;
+    for (size_t i = 0; i < samples.size(); i++) {
+        const FrameSample& s = samples[i];
+        double f = s.updateMs + s.renderMs;
+        frameMs.push_back(f);
+        total += f;
+        csv << i << "," << s.updateMs << "," << s.renderMs << "," << f << ","
+            << s.stats.chunksDrawn << "," << s.stats.chunksCulled << ","
+            << s.stats.trianglesDrawn << "," << s.schedule.uploads << ","
+            << s.schedule.inFlight << "\n";
+    }
+
+    double mean = samples.empty() ? 0.0 : total / double(samples.size());
+    std::cout << "Headless run: " << samples.size() << " frames at " << m_width << "x" << m_height
+              << ", frame mean " << mean << " ms, p50 " << percentile(frameMs, 0.50)
+              << " ms, p95 " << percentile(frameMs, 0.95) << " ms, p99 "
+              << percentile(frameMs, 0.99) << " ms" << std::endl;
+    std::cout << "Per-frame times written to " << m_options.csvPath << std::endl;
+}
@@ -3,12 +3,36 @@
 #include <string>
 #include <memory>
 
+#include "terrain/demSource.h"
+
 class Camera;
+class FrameUniformBuffer;
 class Shader;
 class TerrainManager;
 
 struct GLFWwindow;
 
+// Command line options, parsed in main.cpp
+struct AppOptions {
+    std::string demPath;        // empty shows the procedural terrain
+    DemSettings dem;
+
+    // empty runs without a tile cache; a pack from terrain_bake only
+    // applies to the parameters it was baked with
+    std::string tilePackPath;
+    GeneratorParams params;
+
+    // Offscreen benchmark: no window or UI, the camera follows cameraPath
+    // (or a built-in flyover) with vsync off and every frame goes to csvPath
+    bool headless = false;
+    std::string cameraPath;
+    int frames = 0;             // 0 runs to the last key of the path
+    std::string csvPath = "flythrough.csv";
+    // wait for streaming to catch up before each timed frame, so runs
+    // compare rendering rather than how far behind the builders were
+    bool settle = true;
+};
+
 class Application {
 public:
     // TODO: patch exposed variables
@@ -24,15 +48,18 @@ public:
     int m_gridDepth = 64;
 
     std::unique_ptr<TerrainManager> m_terrain;
+    std::unique_ptr<FrameUniformBuffer> m_frameUniforms;
     std::unique_ptr<Shader> m_shader;
     std::unique_ptr<Camera> m_camera;
 
-    Application(int width = 1280, int height = 800, const std::string& title = "Terrain Viewer");
+    Application(const AppOptions& options = {}, int width = 1280, int height = 800,
+                const std::string& title = "Terrain Viewer");
     ~Application();
 
     void run();
 
 private:
+    void runHeadless();
 
     void initWindow();
     void initOpenGL();
@@ -42,13 +69,21 @@ private:
     void update(float dt);
     void render();
     void toggleMouseCapture();
+    void createOffscreenTarget();
 
 private:
+    AppOptions m_options;
     int m_width;
     int m_height;
     std::string m_title;
 
     GLFWwindow* m_window = nullptr;
+    // render target of headless runs, the window is never shown
+    unsigned int m_fbo = 0;
+    unsigned int m_fboColor = 0;
+    unsigned int m_fboDepth = 0;
+    // seconds, what the shaders see as time; frame-locked when headless
+    double m_frameTime = 0.0;
     bool m_running = true;
     bool mouseCaptured = true; // start in camera mode
 };
@@ -0,0 +1,69 @@
+#include "cameraPath.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+bool CameraPath::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "[CameraPath] failed to open " << path << std::endl;
+        return false;
+    }
+
+    m_keys.clear();
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.resize(hash);
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+
+        std::istringstream ss(line);
+        CameraKey key;
+        if (!(ss >> key.frame >> key.position.x >> key.position.y >> key.position.z
+                 >> key.yaw >> key.pitch)) {
+            std::cerr << "[CameraPath] " << path << ":" << lineNumber
+                      << ": expected frame x y z yaw pitch" << std::endl;
+            return false;
+        }
+        m_keys.push_back(key);
+    }
+
+    std::stable_sort(m_keys.begin(), m_keys.end(),
+        [](const CameraKey& a, const CameraKey& b) { return a.frame < b.frame; });
+
+    if (m_keys.empty()) {
+        std::cerr << "[CameraPath] " << path << " has no keys" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+CameraPath CameraPath::flyover() {
+    // 600 frames along +x at a fixed height, then a turn to look back
+    CameraPath path;
+    path.m_keys = {
+        { 0,   { 0.0f,     400.0f, 0.0f }, 0.0f,   -15.0f },
+        { 500, { 12000.0f, 400.0f, 0.0f }, 0.0f,   -15.0f },
+        { 600, { 12000.0f, 600.0f, 0.0f }, 180.0f, -25.0f },
+    };
+    return path;
+}
+
+CameraKey CameraPath::at(float frame) const {
+    if (m_keys.empty()) return { int(frame), glm::vec3(0.0f), -90.0f, 0.0f };
+    if (frame <= float(m_keys.front().frame)) return m_keys.front();
+    if (frame >= float(m_keys.back().frame)) return m_keys.back();
+
+    auto next = std::upper_bound(m_keys.begin(), m_keys.end(), frame,
+        [](float f, const CameraKey& k) { return f < float(k.frame); });
+    const CameraKey& b = *next;
+    const CameraKey& a = *(next - 1);
+
+    float t = (frame - float(a.frame)) / float(std::max(1, b.frame - a.frame));
+    return { int(frame), glm::mix(a.position, b.position, t),
+             glm::mix(a.yaw, b.yaw, t), glm::mix(a.pitch, b.pitch, t) };
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+struct CameraKey {
+    int frame;
+    glm::vec3 position;
+    float yaw;                  // degrees, like Camera
+    float pitch;
+};
+
+// Scripted camera for headless runs. The file holds one key per line,
+//
+//   # frame  x  y  z  yaw  pitch
+//   0      0  400  0     -90  -20
+//   600    6000 400 0    -90  -20
+//
+// keys sorted by frame, poses in between are interpolated linearly.
+// Poses only depend on the frame number, never on time.
+class CameraPath {
+public:
+    // Returns false if the file can't be read or holds no keys
+    bool load(const std::string& path);
+
+    // A straight flight across a few view radii, used without a file
+    static CameraPath flyover();
+
+    // Fractional frames replay the path slower or faster
+    CameraKey at(float frame) const;
+    int lastFrame() const { return m_keys.empty() ? 0 : m_keys.back().frame; }
+
+private:
+    std::vector<CameraKey> m_keys;
+};
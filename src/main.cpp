@@ -1,8 +1,97 @@
 #include "app/application.h"
 
-int main() {
-    Application app;
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+static void usage() {
+    std::cerr << "usage: terrain_viewer [--seed N] [--noise-scale F] [--octaves N] [--mix F]\n"
+                 "                      [--tile-pack file]\n"
+                 "                      [--dem file] [--dem-format hgt|raw16|f32]\n"
+                 "                      [--dem-size WxH] [--dem-range min,max]\n"
+                 "                      [--headless] [--camera-path file] [--frames N]\n"
+                 "                      [--csv file] [--no-settle] [--resolution WxH]\n";
+}
+
+int main(int argc, char** argv) {
+    AppOptions options;
+    bool formatGiven = false;
+    bool rangeGiven = false;
+    int width = 1280;
+    int height = 800;
+
+    for (int i = 1; i < argc; i++) {
+        auto arg = [&](const char* name) {
+            return std::strcmp(argv[i], name) == 0 && i + 1 < argc;
+        };
+
+        if (std::strcmp(argv[i], "--headless") == 0) {
+            options.headless = true;
+        } else if (std::strcmp(argv[i], "--no-settle") == 0) {
+            options.settle = false;
+        } else if (arg("--camera-path")) {
+            options.cameraPath = argv[++i];
+        } else if (arg("--frames")) {
+            options.frames = std::atoi(argv[++i]);
+        } else if (arg("--csv")) {
+            options.csvPath = argv[++i];
+        } else if (arg("--resolution")) {
+            if (std::sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0) {
+                usage();
+                return 1;
+            }
+        } else if (arg("--seed")) {
+            options.params.seed = std::atoi(argv[++i]);
+        } else if (arg("--noise-scale")) {
+            options.params.noiseScale = float(std::atof(argv[++i]));
+        } else if (arg("--octaves")) {
+            options.params.octaves = std::max(1, std::atoi(argv[++i]));
+        } else if (arg("--mix")) {
+            options.params.mixRatio = float(std::atof(argv[++i]));
+        } else if (arg("--tile-pack")) {
+            options.tilePackPath = argv[++i];
+        } else if (arg("--dem")) {
+            options.demPath = argv[++i];
+        } else if (arg("--dem-format")) {
+            std::string format = argv[++i];
+            if (format == "hgt") options.dem.format = DemFormat::Hgt;
+            else if (format == "raw16") options.dem.format = DemFormat::Raw16;
+            else if (format == "f32") options.dem.format = DemFormat::Float32;
+            else { usage(); return 1; }
+            formatGiven = true;
+        } else if (arg("--dem-size")) {
+            if (std::sscanf(argv[++i], "%dx%d", &options.dem.width, &options.dem.height) != 2) {
+                usage();
+                return 1;
+            }
+        } else if (arg("--dem-range")) {
+            if (std::sscanf(argv[++i], "%f,%f", &options.dem.minElevation,
+                            &options.dem.maxElevation) != 2) {
+                usage();
+                return 1;
+            }
+            rangeGiven = true;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    if (!options.demPath.empty()) {
+        if (!formatGiven) options.dem.format = demFormatFromPath(options.demPath);
+
+        // 16-bit rasters usually span the whole integer range, the other
+        // formats are in metres
+        if (!rangeGiven && options.dem.format == DemFormat::Raw16) {
+            options.dem.minElevation = 0.0f;
+            options.dem.maxElevation = 65535.0f;
+        }
+    }
+
+    Application app(options, width, height);
     app.run();
     return 0;
 }
-
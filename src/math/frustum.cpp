@@ -0,0 +1,43 @@
+#include "frustum.h"
+
+Frustum Frustum::fromMatrix(const glm::mat4& m) {
+    // glm is column-major, so row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+    auto row = [&](int i) {
+        return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+    };
+
+    glm::vec4 r0 = row(0);
+    glm::vec4 r1 = row(1);
+    glm::vec4 r2 = row(2);
+    glm::vec4 r3 = row(3);
+
+    Frustum f;
+    f.planes[0] = r3 + r0;  // left
+    f.planes[1] = r3 - r0;  // right
+    f.planes[2] = r3 + r1;  // bottom
+    f.planes[3] = r3 - r1;  // top
+    f.planes[4] = r3 + r2;  // near
+    f.planes[5] = r3 - r2;  // far
+
+    for (auto& p : f.planes) {
+        float len = glm::length(glm::vec3(p.x, p.y, p.z));
+        if (len > 0.0f) p = p / len;
+    }
+    return f;
+}
+
+bool Frustum::intersects(const AABB& box) const {
+    for (const auto& p : planes) {
+        // the corner farthest along the plane normal
+        glm::vec3 v{
+            p.x >= 0.0f ? box.max.x : box.min.x,
+            p.y >= 0.0f ? box.max.y : box.min.y,
+            p.z >= 0.0f ? box.max.z : box.min.z
+        };
+
+        if (p.x * v.x + p.y * v.y + p.z * v.z + p.w < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+struct AABB {
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
+// Six planes (left, right, bottom, top, near, far) stored as (n, d) with
+// the normal pointing inside, so dot(n, p) + d >= 0 for points inside.
+struct Frustum {
+    glm::vec4 planes[6];
+
+    // Extracts the planes from a projection * view matrix
+    static Frustum fromMatrix(const glm::mat4& viewProj);
+
+    // Conservative: boxes straddling a plane count as visible
+    bool intersects(const AABB& box) const;
+};
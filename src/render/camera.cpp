@@ -29,6 +29,21 @@ void Camera::processMouse(float dx, float dy) {
     updateVectors();
 }
 
+void Camera::setPose(const glm::vec3& pos, float yaw, float pitch) {
+    m_pos = pos;
+    m_yaw = yaw;
+    m_pitch = glm::clamp(pitch, -89.0f, 89.0f);
+    updateVectors();
+}
+
+void Camera::updateVelocity(float dt) {
+    if (m_hasLastPos && dt > 0.0f) {
+        m_velocity = (m_pos - m_lastPos) / dt;
+    }
+    m_lastPos = m_pos;
+    m_hasLastPos = true;
+}
+
 void Camera::processScroll(float dy) {
     m_fov -= dy;
     if (m_fov < 20.0f) m_fov = 20.0f;
@@ -43,6 +58,10 @@ glm::mat4 Camera::projection() const {
     return glm::perspective(glm::radians(m_fov), m_aspect, m_near, m_far);
 }
 
+Frustum Camera::frustum() const {
+    return Frustum::fromMatrix(projection() * view());
+}
+
 void Camera::updateVectors() {
     glm::vec3 front{
         cos(glm::radians(m_yaw)) * cos(glm::radians(m_pitch)),
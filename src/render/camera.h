@@ -3,6 +3,8 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "math/frustum.h"
+
 class Camera {
 public:
     Camera(float fovDeg, float aspect, float nearZ, float farZ);
@@ -13,10 +15,20 @@ public:
     void processMouse(float dx, float dy);
     void processScroll(float dy);
 
+    // Places the camera directly, angles in degrees like processMouse()
+    void setPose(const glm::vec3& pos, float yaw, float pitch);
+
+    // Measures velocity from the movement since the last call, once per frame
+    void updateVelocity(float dt);
+
     glm::mat4 view() const;
     glm::mat4 projection() const;
+    Frustum frustum() const;
 
     const glm::vec3& position() const { return m_pos; }
+    const glm::vec3& front() const { return m_front; }
+    // world units per second, zero until updateVelocity() ran twice
+    const glm::vec3& velocity() const { return m_velocity; }
 
 private:
     void updateVectors();
@@ -27,6 +39,10 @@ private:
     glm::vec3 m_up{0.0f, 1.0f, 0.0f};
     glm::vec3 m_right{1.0f, 0.0f, 0.0f};
 
+    glm::vec3 m_velocity{0.0f};
+    glm::vec3 m_lastPos{0.0f};
+    bool m_hasLastPos = false;
+
     float m_yaw   = -90.0f;
     float m_pitch = 0.0f;
 
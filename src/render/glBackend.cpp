@@ -0,0 +1,109 @@
+#include "glBackend.h"
+#include "shader.h"
+#include "terrain/chunkGen.h"
+#include <cstddef>
+
+GLBackend::~GLBackend() {
+    destroyArena();
+}
+
+void GLBackend::createArena(uint32_t slotCount, size_t slotBytes,
+                            const uint16_t* indices, size_t indexCount) {
+    m_slotBytes = slotBytes;
+    m_slotVerts = int(slotBytes / sizeof(ChunkVertex));
+
+    glGenVertexArrays(1, &m_vao);
+    glGenBuffers(1, &m_vbo);
+    glGenBuffers(1, &m_ebo);
+
+    glBindVertexArray(m_vao);
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    glBufferData(GL_ARRAY_BUFFER, slotCount * slotBytes, nullptr, GL_DYNAMIC_DRAW);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+        indexCount * sizeof(uint16_t),
+        indices,
+        GL_STATIC_DRAW);
+
+    // integer attributes go through unnormalized, the shader rescales them
+    // so the result doesn't depend on the GL version's snorm rules
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 1, GL_SHORT, GL_FALSE, sizeof(ChunkVertex), (void*)0);
+
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_BYTE, GL_FALSE,
+        sizeof(ChunkVertex), (void*)offsetof(ChunkVertex, normal));
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // one RGBA32F texel per slot, see ChunkSlotInfo
+    glGenBuffers(1, &m_slotBuffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, m_slotBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, slotCount * sizeof(glm::vec4), nullptr, GL_DYNAMIC_DRAW);
+
+    glGenTextures(1, &m_slotTexture);
+    glBindTexture(GL_TEXTURE_BUFFER, m_slotTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_slotBuffer);
+
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void GLBackend::destroyArena() {
+    if (m_slotTexture) glDeleteTextures(1, &m_slotTexture);
+    if (m_slotBuffer) glDeleteBuffers(1, &m_slotBuffer);
+    if (m_ebo) glDeleteBuffers(1, &m_ebo);
+    if (m_vbo) glDeleteBuffers(1, &m_vbo);
+    if (m_vao) glDeleteVertexArrays(1, &m_vao);
+    m_vao = m_vbo = m_ebo = m_slotBuffer = m_slotTexture = 0;
+}
+
+void GLBackend::uploadSlot(int slot, const ChunkVertex* vertices, int count,
+                           const ChunkSlotInfo& info) {
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    glBufferSubData(GL_ARRAY_BUFFER,
+        slot * m_slotBytes,
+        count * sizeof(ChunkVertex),
+        vertices);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glm::vec4 texel(info.origin.x, info.origin.z, float(info.gridVerts), info.gridSpacing);
+    glBindBuffer(GL_TEXTURE_BUFFER, m_slotBuffer);
+    glBufferSubData(GL_TEXTURE_BUFFER, slot * sizeof(texel), sizeof(texel), &texel);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void GLBackend::drawChunks(const Shader& shader, const ChunkDrawList& list) {
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, m_slotTexture);
+    if (m_uniforms.shader != &shader) {
+        m_uniforms.shader = &shader;
+        m_uniforms.chunkSlots = shader.uniform("uChunkSlots");
+        m_uniforms.slotVerts = shader.uniform("uSlotVerts");
+        m_uniforms.heightScale = shader.uniform("uHeightScale");
+        m_uniforms.normalScale = shader.uniform("uNormalScale");
+    }
+    shader.setInt(m_uniforms.chunkSlots, 0);
+    shader.setInt(m_uniforms.slotVerts, m_slotVerts);
+    shader.setFloat(m_uniforms.heightScale, list.heightScale);
+    shader.setFloat(m_uniforms.normalScale, CHUNK_NORMAL_SCALE);
+
+    // the restart index is compared before the base vertex is added
+    glEnable(GL_PRIMITIVE_RESTART);
+    glPrimitiveRestartIndex(CHUNK_RESTART_INDEX);
+
+    glBindVertexArray(m_vao);
+    glMultiDrawElementsBaseVertex(GL_TRIANGLE_STRIP,
+        list.counts,
+        GL_UNSIGNED_SHORT,
+        list.offsets,
+        list.drawCount,
+        list.baseVertices);
+
+    glDisable(GL_PRIMITIVE_RESTART);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include "terrain/gpuBackend.h"
+
+// GpuBackend on the current OpenGL 3.3 context. Must be used from the
+// thread that owns it.
+class GLBackend : public GpuBackend {
+public:
+    GLBackend() = default;
+    ~GLBackend() override;
+
+    GLBackend(const GLBackend&) = delete;
+    GLBackend& operator=(const GLBackend&) = delete;
+
+    void createArena(uint32_t slotCount, size_t slotBytes,
+                     const uint16_t* indices, size_t indexCount) override;
+    void destroyArena() override;
+    void uploadSlot(int slot, const ChunkVertex* vertices, int count,
+                    const ChunkSlotInfo& info) override;
+    void drawChunks(const Shader& shader, const ChunkDrawList& list) override;
+
+private:
+    GLuint m_vao = 0;
+    GLuint m_vbo = 0;
+    GLuint m_ebo = 0;
+    GLuint m_slotBuffer = 0;
+    GLuint m_slotTexture = 0;
+    size_t m_slotBytes = 0;
+    int m_slotVerts = 0;
+
+    // uniform handles of the shader drawChunks() last ran with
+    struct DrawUniforms {
+        const Shader* shader = nullptr;
+        int chunkSlots = -1;
+        int slotVerts = -1;
+        int heightScale = -1;
+        int normalScale = -1;
+    };
+    DrawUniforms m_uniforms;
+};
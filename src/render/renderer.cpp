@@ -0,0 +1,25 @@
+#include <glad/gl.h>
+
+#include "renderer.h"
+
+FrameUniformBuffer::FrameUniformBuffer() {
+    glGenBuffers(1, &m_ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    // stays bound, programs only refer to the binding point
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORM_BINDING, m_ubo);
+}
+
+FrameUniformBuffer::~FrameUniformBuffer() {
+    glDeleteBuffers(1, &m_ubo);
+}
+
+void FrameUniformBuffer::update(const FrameUniforms& frame) {
+    glBindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+    // orphan last frame's copy instead of waiting for draws still reading it
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), nullptr, GL_DYNAMIC_DRAW);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &frame);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
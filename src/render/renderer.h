@@ -0,0 +1,38 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// Constants every terrain program reads once per frame. Mirrors the
+// std140 FrameUniforms block in the shaders: only mat4 and vec4 members,
+// so the C++ layout matches without padding.
+struct FrameUniforms {
+    glm::mat4 view;
+    glm::mat4 proj;
+    glm::mat4 viewProj;
+    glm::vec4 cameraPos;        // w unused
+    glm::vec4 lightDir;         // normalized, w unused
+    glm::vec4 params;           // x: time in seconds
+};
+static_assert(sizeof(FrameUniforms) == 3 * 64 + 3 * 16, "FrameUniforms must match std140");
+
+// Binding point of the FrameUniforms block. Shader binds every program
+// that declares the block here when it's linked.
+constexpr unsigned int FRAME_UNIFORM_BINDING = 0;
+constexpr const char* FRAME_UNIFORM_BLOCK = "FrameUniforms";
+
+// The uniform buffer behind FrameUniforms, filled once per frame and
+// shared by every program
+class FrameUniformBuffer {
+public:
+    // Must run on the thread that owns the GL context
+    FrameUniformBuffer();
+    ~FrameUniformBuffer();
+
+    FrameUniformBuffer(const FrameUniformBuffer&) = delete;
+    FrameUniformBuffer& operator=(const FrameUniformBuffer&) = delete;
+
+    void update(const FrameUniforms& frame);
+
+private:
+    unsigned int m_ubo = 0;
+};
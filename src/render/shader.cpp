@@ -1,6 +1,7 @@
 #include <glad/gl.h>
 
 #include "shader.h"
+#include "renderer.h"
 
 #include <fstream>
 #include <sstream>
@@ -29,6 +30,42 @@ Shader::Shader(const std::string& vertexPath,
 
     glDeleteShader(vs);
     glDeleteShader(fs);
+
+    if (ok) reflect();
+}
+
+void Shader::reflect() {
+    int count = 0;
+    glGetProgramiv(m_program, GL_ACTIVE_UNIFORMS, &count);
+
+    for (int i = 0; i < count; i++) {
+        char name[256];
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(m_program, GLuint(i), sizeof(name), &length, &size, &type, name);
+
+        // block members have no location
+        int location = glGetUniformLocation(m_program, name);
+        if (location < 0) continue;
+
+        // arrays are reported as "name[0]", accept the bare name too
+        std::string key(name, size_t(length));
+        if (key.size() > 3 && key.compare(key.size() - 3, 3, "[0]") == 0) {
+            m_uniforms[key.substr(0, key.size() - 3)] = location;
+        }
+        m_uniforms[key] = location;
+    }
+
+    GLuint frameBlock = glGetUniformBlockIndex(m_program, FRAME_UNIFORM_BLOCK);
+    if (frameBlock != GL_INVALID_INDEX) {
+        glUniformBlockBinding(m_program, frameBlock, FRAME_UNIFORM_BINDING);
+    }
+}
+
+int Shader::uniform(const std::string& name) const {
+    auto it = m_uniforms.find(name);
+    return it != m_uniforms.end() ? it->second : -1;
 }
 
 Shader::~Shader() {
@@ -66,17 +103,34 @@ std::string Shader::loadFile(const std::string& path) {
     return ss.str();
 }
 
+void Shader::setMat4(int location, const glm::mat4& m) const {
+    glUniformMatrix4fv(location, 1, GL_FALSE, &m[0][0]);
+}
+
+void Shader::setVec3(int location, const glm::vec3& v) const {
+    glUniform3fv(location, 1, &v[0]);
+}
+
+void Shader::setFloat(int location, float v) const {
+    glUniform1f(location, v);
+}
+
+void Shader::setInt(int location, int v) const {
+    glUniform1i(location, v);
+}
+
 void Shader::setMat4(const std::string& name, const glm::mat4& m) const {
-    glUniformMatrix4fv(glGetUniformLocation(m_program, name.c_str()),
-                       1, GL_FALSE, &m[0][0]);
+    setMat4(uniform(name), m);
 }
 
 void Shader::setVec3(const std::string& name, const glm::vec3& v) const {
-    glUniform3fv(glGetUniformLocation(m_program, name.c_str()),
-                 1, &v[0]);
+    setVec3(uniform(name), v);
 }
 
 void Shader::setFloat(const std::string& name, float v) const {
-    glUniform1f(glGetUniformLocation(m_program, name.c_str()), v);
+    setFloat(uniform(name), v);
 }
 
+void Shader::setInt(const std::string& name, int v) const {
+    setInt(uniform(name), v);
+}
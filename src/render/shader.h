@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <unordered_map>
 #include <glm/glm.hpp>
 
 class Shader {
@@ -12,12 +13,28 @@ public:
     void bind() const;
     void unbind() const;
 
+    // Location of an active uniform, resolved once at link time. -1 if the
+    // program doesn't use it; the setters ignore -1 like GL does.
+    int uniform(const std::string& name) const;
+
+    // Handle-based setters, the cheap path for anything set every frame
+    void setMat4(int location, const glm::mat4& m) const;
+    void setVec3(int location, const glm::vec3& v) const;
+    void setFloat(int location, float v) const;
+    void setInt(int location, int v) const;
+
+    // By name, looked up in the cache rather than asking GL
     void setMat4(const std::string& name, const glm::mat4& m) const;
     void setVec3(const std::string& name, const glm::vec3& v) const;
     void setFloat(const std::string& name, float v) const;
+    void setInt(const std::string& name, int v) const;
 
 private:
     unsigned int m_program = 0;
+    std::unordered_map<std::string, int> m_uniforms;
+
+    // Caches every active uniform and binds the shared uniform blocks
+    void reflect();
 
     std::string loadFile(const std::string& path);
     unsigned int compile(unsigned int type, const std::string& src);
@@ -0,0 +1,45 @@
+#include "chunkArena.h"
+
+ChunkArena::~ChunkArena() {
+    if (m_gpu) m_gpu->destroyArena();
+}
+
+void ChunkArena::create(GpuBackend& gpu, uint32_t slotCount) {
+    m_capacity = slotCount;
+
+    // hand out low slots first
+    m_free.clear();
+    for (int i = (int)slotCount - 1; i >= 0; i--) {
+        m_free.push_back(i);
+    }
+
+    std::vector<uint16_t> indices;
+    std::vector<uint16_t> level;
+    for (int l = 0; l <= MAX_CHUNK_LOD; l++) {
+        buildChunkIndices(level, chunkLodVerts(l));
+        m_indexOffsets[l] = indices.size();
+        m_indexCounts[l] = (int)level.size();
+        indices.insert(indices.end(), level.begin(), level.end());
+    }
+
+    gpu.createArena(slotCount, slotBytes(), indices.data(), indices.size());
+    m_gpu = &gpu;
+}
+
+int ChunkArena::allocate() {
+    if (m_free.empty()) return -1;
+
+    int slot = m_free.back();
+    m_free.pop_back();
+    return slot;
+}
+
+void ChunkArena::release(int slot) {
+    // nothing to clear on the GPU, the slot is simply no longer drawn
+    m_free.push_back(slot);
+}
+
+void ChunkArena::upload(int slot, const ChunkVertex* vertices, int count,
+                        const ChunkSlotInfo& info) {
+    m_gpu->uploadSlot(slot, vertices, count, info);
+}
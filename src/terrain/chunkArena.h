@@ -0,0 +1,50 @@
+#pragma once
+#include "chunkGen.h"
+#include "const.h"
+#include "gpuBackend.h"
+#include <cstdint>
+#include <vector>
+
+// One vertex buffer holding every resident chunk in fixed-size slots and
+// one index buffer with the strip indices of every LOD level. Chunks are
+// drawn by base vertex, slot * SLOT_VERTS. The buffers themselves live in
+// a GpuBackend, the arena only hands out slots.
+class ChunkArena {
+public:
+    static constexpr int SLOT_VERTS = CHUNK_VERTS * CHUNK_VERTS;
+
+    ChunkArena() = default;
+    ~ChunkArena();
+
+    ChunkArena(const ChunkArena&) = delete;
+    ChunkArena& operator=(const ChunkArena&) = delete;
+
+    // Must run on the thread that owns the backend's context
+    void create(GpuBackend& gpu, uint32_t slotCount);
+    bool isCreated() const { return m_gpu != nullptr; }
+
+    // Returns -1 when every slot is taken
+    int allocate();
+    void release(int slot);
+
+    void upload(int slot, const ChunkVertex* vertices, int count, const ChunkSlotInfo& info);
+
+    uint32_t capacity() const { return m_capacity; }
+    uint32_t freeSlots() const { return (uint32_t)m_free.size(); }
+    static size_t slotBytes() { return size_t(SLOT_VERTS) * sizeof(ChunkVertex); }
+
+    // Strip indices of a LOD level inside the shared index buffer
+    int indexCount(int level) const { return m_indexCounts[level]; }
+    const void* indexOffset(int level) const {
+        return (const void*)(m_indexOffsets[level] * sizeof(uint16_t));
+    }
+
+private:
+    GpuBackend* m_gpu = nullptr;
+
+    uint32_t m_capacity = 0;
+    std::vector<int> m_free;
+
+    int m_indexCounts[MAX_CHUNK_LOD + 1] = {};
+    size_t m_indexOffsets[MAX_CHUNK_LOD + 1] = {};
+};
@@ -0,0 +1,148 @@
+#include "chunkBuilder.h"
+#include "util/log.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+ChunkBuilder::ChunkBuilder(unsigned threadCount) {
+    if (threadCount == 0) {
+        // leave one core for the render thread
+        unsigned hw = std::thread::hardware_concurrency();
+        threadCount = hw > 1 ? hw - 1 : 1;
+    }
+
+    for (unsigned i = 0; i < threadCount; i++) {
+        m_workers.emplace_back(&ChunkBuilder::workerLoop, this);
+    }
+}
+
+ChunkBuilder::~ChunkBuilder() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+        for (auto& [_, flag] : m_pending) {
+            flag->store(true);
+        }
+    }
+    m_cv.notify_all();
+
+    for (auto& t : m_workers) {
+        t.join();
+    }
+}
+
+bool ChunkBuilder::request(ChunkCoord coord, ChunkLod lod,
+                           std::shared_ptr<const HeightmapSource> source,
+                           TilePack* cache) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_pending.count(coord)) return false;
+
+        auto flag = std::make_shared<std::atomic<bool>>(false);
+        m_pending.emplace(coord, flag);
+        m_jobs.push_back({ coord, lod, std::move(source), cache, flag });
+    }
+    m_cv.notify_one();
+    return true;
+}
+
+bool ChunkBuilder::isPending(ChunkCoord coord) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pending.count(coord) != 0;
+}
+
+void ChunkBuilder::cancelOutside(ChunkCoord center, int radius) {
+    auto outside = [&](ChunkCoord c) {
+        return abs(c.x - center.x) > radius || abs(c.z - center.z) > radius;
+    };
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_jobs.erase(std::remove_if(m_jobs.begin(), m_jobs.end(),
+        [&](const Job& j) { return outside(j.coord); }), m_jobs.end());
+
+    for (auto it = m_pending.begin(); it != m_pending.end();) {
+        if (outside(it->first)) {
+            // in-flight work notices the flag and throws its result away
+            it->second->store(true);
+            it = m_pending.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    m_completed.erase(std::remove_if(m_completed.begin(), m_completed.end(),
+        [&](const std::unique_ptr<TerrainChunk>& c) { return outside(c->coord); }),
+        m_completed.end());
+}
+
+void ChunkBuilder::collect(std::vector<std::unique_ptr<TerrainChunk>>& out) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& chunk : m_completed) {
+        m_pending.erase(chunk->coord);
+        out.push_back(std::move(chunk));
+    }
+    m_completed.clear();
+}
+
+size_t ChunkBuilder::pendingCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pending.size();
+}
+
+void ChunkBuilder::workerLoop() {
+    profileThreadName("chunk worker");
+
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [&] { return m_stop || !m_jobs.empty(); });
+            if (m_stop) return;
+
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+
+        if (job.cancelled->load()) continue;
+
+        PROFILE_ZONE("chunk build");
+        auto start = std::chrono::steady_clock::now();
+        auto chunk = std::make_unique<TerrainChunk>(job.coord, job.lod);
+        uint64_t hash = job.source->hash();
+        chunk->paramsHash = hash;
+
+        bool cached = job.cache && job.cache->read(job.coord, job.lod.level, hash,
+            [&](const float* heights, const float* gradients, HeightRange range) {
+                PROFILE_ZONE("chunk mesh");
+                chunk->heightRange = range;
+                chunk->buildMesh(heights, gradients);
+            });
+
+        if (!cached) {
+            {
+                PROFILE_ZONE("chunk heightmap");
+                chunk->generateHeightmap(*job.source);
+            }
+
+            if (job.cancelled->load()) continue;
+
+            if (job.cache) {
+                PROFILE_ZONE("tile cache write");
+                job.cache->write(job.coord, job.lod.level, hash,
+                    chunk->heightmap.data(), chunk->gradients.data(), chunk->heightRange);
+            }
+
+            PROFILE_ZONE("chunk mesh");
+            chunk->buildMesh();
+        }
+
+        chunk->buildMs = std::chrono::duration<float, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!job.cancelled->load()) {
+            m_completed.push_back(std::move(chunk));
+        }
+    }
+}
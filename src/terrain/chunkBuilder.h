@@ -0,0 +1,64 @@
+#pragma once
+#include "heightmapSource.h"
+#include "terrainChunk.h"
+#include "tilePack.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Runs heightmap generation and CPU meshing on worker threads.
+// Finished chunks wait in a completion queue until the GL thread
+// collects and uploads them. With a tile cache attached, heightmaps
+// found there are meshed straight from the mapping and new ones are
+// written back.
+class ChunkBuilder {
+public:
+    explicit ChunkBuilder(unsigned threadCount = 0);
+    ~ChunkBuilder();
+
+    ChunkBuilder(const ChunkBuilder&) = delete;
+    ChunkBuilder& operator=(const ChunkBuilder&) = delete;
+
+    // Returns false if the chunk was already queued or in flight. The job
+    // keeps the source alive until it's done.
+    bool request(ChunkCoord coord, ChunkLod lod,
+                 std::shared_ptr<const HeightmapSource> source,
+                 TilePack* cache = nullptr);
+    bool isPending(ChunkCoord coord) const;
+
+    // Drops every queued or in-flight chunk farther than radius from center
+    void cancelOutside(ChunkCoord center, int radius);
+
+    // Moves finished chunks into out, they still need upload()
+    void collect(std::vector<std::unique_ptr<TerrainChunk>>& out);
+
+    size_t pendingCount() const;
+    size_t workerCount() const { return m_workers.size(); }
+
+private:
+    struct Job {
+        ChunkCoord coord;
+        ChunkLod lod;
+        std::shared_ptr<const HeightmapSource> source;
+        TilePack* cache;
+        std::shared_ptr<std::atomic<bool>> cancelled;
+    };
+
+    void workerLoop();
+
+    std::vector<std::thread> m_workers;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<Job> m_jobs;
+    std::unordered_map<ChunkCoord,
+        std::shared_ptr<std::atomic<bool>>,
+        ChunkCoordHash> m_pending;
+    std::vector<std::unique_ptr<TerrainChunk>> m_completed;
+    bool m_stop = false;
+};
@@ -0,0 +1,16 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+
+struct ChunkCoord {
+    int x, z;
+    bool operator==(const ChunkCoord& o) const {
+        return x == o.x && z == o.z;
+    }
+};
+
+struct ChunkCoordHash {
+    size_t operator()(const ChunkCoord& c) const {
+        return (std::hash<int>()(c.x) << 1) ^ std::hash<int>()(c.z);
+    }
+};
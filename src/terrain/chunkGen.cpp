@@ -0,0 +1,261 @@
+#include "chunkGen.h"
+#include "const.h"
+#include "noise.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static_assert(CHUNK_VERTS * CHUNK_VERTS <= CHUNK_RESTART_INDEX,
+    "chunk vertices must be addressable with 16-bit indices");
+
+uint64_t generatorHash(const GeneratorParams& params) {
+    // FNV-1a over the fields, the noise scale by bit pattern
+    uint64_t h = 1469598103934665603ull;
+    auto mix = [&](uint32_t v) {
+        for (int i = 0; i < 4; i++) {
+            h ^= (v >> (i * 8)) & 0xff;
+            h *= 1099511628211ull;
+        }
+    };
+
+    uint32_t scaleBits;
+    std::memcpy(&scaleBits, &params.noiseScale, sizeof(scaleBits));
+    uint32_t mixBits;
+    std::memcpy(&mixBits, &params.mixRatio, sizeof(mixBits));
+
+    mix((uint32_t)params.seed);
+    mix(scaleBits);
+    mix((uint32_t)params.octaves);
+    mix(mixBits);
+    mix((uint32_t)CHUNK_SIZE);
+    return h;
+}
+
+// One row of unclamped heights at xs: fBm with the Voronoi term blended in
+static void chunkHeightRow(float* row, const float* xs, int count, float wz,
+                           const GeneratorParams& params, const VoronoiCells& cells) {
+    perlinFbmRow(row, xs, count, wz, params.seed, params.octaves);
+
+    const float mix = params.mixRatio;
+    if (mix != 0.0f) {
+        for (int x = 0; x < count; x++) {
+            float v = cells.distance(xs[x] * 0.5f, wz * 0.5f);
+            row[x] = (1.0f - mix) * row[x] + mix * (1.0f - v * 2.0f);
+        }
+    }
+}
+
+HeightRange generateChunkHeightmap(float* heightmap, float* gradients, ChunkCoord coord,
+                                   const GeneratorParams& params, int level) {
+    const int n = chunkLodVerts(level);
+    const int step = chunkLodStep(level);
+
+    // gradients need one sample past every edge for central differences
+    const int apron = gradients ? 1 : 0;
+    const int m = n + 2 * apron;
+
+    int wx0 = coord.x * CHUNK_SIZE - apron * step;
+    int wz0 = coord.z * CHUNK_SIZE - apron * step;
+
+    float xs[CHUNK_VERTS + 2];
+    for (int x = 0; x < m; x++) {
+        xs[x] = float(wx0 + x * step) * params.noiseScale;
+    }
+
+    auto rowZ = [&](int z) {
+        return float(wz0 + z * step) * params.noiseScale;
+    };
+
+    // feature points for every cell this chunk touches, hashed once
+    VoronoiCells cells;
+    if (params.mixRatio != 0.0f) {
+        cells.build(xs[0] * 0.5f, rowZ(0) * 0.5f,
+                    xs[m - 1] * 0.5f, rowZ(m - 1) * 0.5f, params.seed + 999);
+    }
+
+    HeightRange range{ 1.0f, -1.0f };
+
+    if (!gradients) {
+        for (int z = 0; z < n; z++) {
+            float* row = &heightmap[z * n];
+            chunkHeightRow(row, xs, n, rowZ(z), params, cells);
+
+            for (int x = 0; x < n; x++) {
+                row[x] = glm::clamp(row[x], -1.0f, 1.0f);
+                range.min = std::min(range.min, row[x]);
+                range.max = std::max(range.max, row[x]);
+            }
+        }
+        return range;
+    }
+
+    // The slopes come from the same samples the mesh is built from, the
+    // analytic derivative of value noise is zero on its lattice and every
+    // sample sits on one. Neighbours evaluate the same noise in their
+    // aprons, so the differences still match across borders. Three rolling
+    // apron rows: the one above, the current one and the one below.
+    float rows[3][CHUNK_VERTS + 2];
+    auto fillRow = [&](int z) {
+        float* row = rows[z % 3];
+        chunkHeightRow(row, xs, m, rowZ(z), params, cells);
+        for (int x = 0; x < m; x++) {
+            row[x] = glm::clamp(row[x], -1.0f, 1.0f);
+        }
+    };
+
+    // per level-0 cell whatever the level
+    const float invSpan = 0.5f / float(step);
+
+    fillRow(0);
+    fillRow(1);
+    for (int z = 0; z < n; z++) {
+        fillRow(z + 2);
+        const float* above = rows[z % 3];
+        const float* center = rows[(z + 1) % 3];
+        const float* below = rows[(z + 2) % 3];
+
+        float* row = &heightmap[z * n];
+        float* gx = &gradients[z * n];
+        float* gz = &gradients[n * n + z * n];
+
+        for (int x = 0; x < n; x++) {
+            row[x] = center[x + 1];
+            gx[x] = (center[x + 2] - center[x]) * invSpan;
+            gz[x] = (below[x + 1] - above[x + 1]) * invSpan;
+
+            range.min = std::min(range.min, row[x]);
+            range.max = std::max(range.max, row[x]);
+        }
+    }
+    return range;
+}
+
+glm::vec3 chunkOrigin(ChunkCoord coord) {
+    return {
+        float(coord.x * CHUNK_SIZE) * CELL_SIZE,
+        0.0f,
+        float(coord.z * CHUNK_SIZE) * CELL_SIZE
+    };
+}
+
+AABB chunkBounds(ChunkCoord coord, HeightRange range, float heightScale) {
+    glm::vec3 o = chunkOrigin(coord);
+    float extent = float(CHUNK_SIZE) * CELL_SIZE;
+
+    float y0 = range.min * heightScale;
+    float y1 = range.max * heightScale;
+
+    return {
+        { o.x, std::min(y0, y1), o.z },
+        { o.x + extent, std::max(y0, y1), o.z + extent }
+    };
+}
+
+int16_t quantizeHeight(float h) {
+    return int16_t(std::lround(glm::clamp(h, -1.0f, 1.0f) * 32767.0f));
+}
+
+static int8_t quantizeSnorm8(float v) {
+    return int8_t(std::lround(glm::clamp(v, -1.0f, 1.0f) * 127.0f));
+}
+
+// Octahedral mapping around +y: project onto |x|+|y|+|z| = 1 and fold the
+// lower half over the upper one, keeping (x, z)
+void encodeOctahedral(const glm::vec3& n, int8_t out[2]) {
+    float l1 = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+    float u = n.x / l1;
+    float v = n.z / l1;
+
+    if (n.y < 0.0f) {
+        float fu = (1.0f - std::fabs(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+        float fv = (1.0f - std::fabs(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+        u = fu;
+        v = fv;
+    }
+
+    out[0] = quantizeSnorm8(u);
+    out[1] = quantizeSnorm8(v);
+}
+
+glm::vec3 decodeOctahedral(const int8_t e[2]) {
+    float u = e[0] / 127.0f;
+    float v = e[1] / 127.0f;
+    glm::vec3 n(u, 1.0f - std::fabs(u) - std::fabs(v), v);
+
+    if (n.y < 0.0f) {
+        float fu = (1.0f - std::fabs(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+        float fv = (1.0f - std::fabs(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+        n.x = fu;
+        n.z = fv;
+    }
+    return glm::normalize(n);
+}
+
+void buildChunkVertices(ChunkVertex* vertices, const float* heightmap,
+                        const float* gradients, ChunkLod lod) {
+    const int n = chunkLodVerts(lod.level);
+    const float* gradX = gradients;
+    const float* gradZ = gradients + n * n;
+
+    for (int z = 0; z < n; z++) {
+        for (int x = 0; x < n; x++) {
+            int i = z * n + x;
+
+            // slopes are per level-0 cell whatever the level, so lighting matches
+            float dx = gradX[i] * CHUNK_NORMAL_SCALE;
+            float dz = gradZ[i] * CHUNK_NORMAL_SCALE;
+
+            glm::vec3 nrm = glm::normalize(glm::vec3(-dx, 1.0f, -dz));
+
+            vertices[i].height = quantizeHeight(heightmap[i]);
+            encodeOctahedral(nrm, vertices[i].normal);
+        }
+    }
+
+    // T-junctions against a coarser neighbour: put every odd edge vertex
+    // on the line between its even neighbours, which is the neighbour's edge
+    auto snap = [&](int i, int prev, int next) {
+        float h = 0.5f * (heightmap[prev] + heightmap[next]);
+        vertices[i].height = quantizeHeight(h);
+    };
+
+    for (int k = 1; k < n - 1; k += 2) {
+        if (lod.coarserEdges & EDGE_NEG_X) {
+            snap(k * n, (k - 1) * n, (k + 1) * n);
+        }
+        if (lod.coarserEdges & EDGE_POS_X) {
+            snap(k * n + n - 1, (k - 1) * n + n - 1, (k + 1) * n + n - 1);
+        }
+        if (lod.coarserEdges & EDGE_NEG_Z) {
+            snap(k, k - 1, k + 1);
+        }
+        if (lod.coarserEdges & EDGE_POS_Z) {
+            int row = (n - 1) * n;
+            snap(row + k, row + k - 1, row + k + 1);
+        }
+    }
+}
+
+void buildChunkIndices(std::vector<uint16_t>& indices, int verticesPerSide) {
+    const int n = verticesPerSide;
+    const int quads = n - 1;
+    const int bands = (quads + CHUNK_STRIP_BAND - 1) / CHUNK_STRIP_BAND;
+
+    indices.clear();
+    indices.reserve(size_t(bands) * quads * (2 * (CHUNK_STRIP_BAND + 1) + 1));
+
+    for (int x0 = 0; x0 < quads; x0 += CHUNK_STRIP_BAND) {
+        int x1 = std::min(x0 + CHUNK_STRIP_BAND, quads);
+
+        for (int z = 0; z < quads; z++) {
+            if (!indices.empty()) {
+                indices.push_back(CHUNK_RESTART_INDEX);
+            }
+
+            for (int x = x0; x <= x1; x++) {
+                indices.push_back(uint16_t(z * n + x));
+                indices.push_back(uint16_t((z + 1) * n + x));
+            }
+        }
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "chunkCoord.h"
+#include "chunkLod.h"
+#include "const.h"
+#include "math/frustum.h"
+
+// CPU side of chunk generation. Nothing here touches GL, so it can run on
+// worker threads and in the headless tools.
+
+// 4 bytes per vertex. x and z are implied by the vertex index and the chunk
+// origin, terrain.vert rebuilds them from gl_VertexID.
+struct ChunkVertex {
+    int16_t height;     // heightmap value in [-1, 1] scaled to +-32767
+    int8_t normal[2];   // octahedral normal at CHUNK_NORMAL_SCALE, +-127
+};
+static_assert(sizeof(ChunkVertex) == 4, "ChunkVertex must stay 4 bytes");
+
+// World position of the chunk's first vertex, height excluded
+glm::vec3 chunkOrigin(ChunkCoord coord);
+
+int16_t quantizeHeight(float h);
+void encodeOctahedral(const glm::vec3& n, int8_t out[2]);
+glm::vec3 decodeOctahedral(const int8_t e[2]);
+
+struct HeightRange {
+    float min;
+    float max;
+};
+
+// Everything that changes generated heights. Cached tiles are only valid
+// for the parameters they were generated with.
+struct GeneratorParams {
+    int seed = 1337;
+    float noiseScale = NOISE_SCALE;
+    int octaves = 4;
+
+    // blend towards 1 - 2 * voronoi distance, the cellular look of
+    // generateHeightmapCPU's mix_ratio. 0 skips the Voronoi pass.
+    float mixRatio = 0.0f;
+};
+
+// Stable across runs and platforms, covers the format constants as well
+uint64_t generatorHash(const GeneratorParams& params);
+
+// Fills chunkLodVerts(level)^2 heights in [-1, 1], row-major by z, and
+// returns their range. Coarse levels only evaluate the samples they keep;
+// those land on the same world positions as at level 0, so shared vertices
+// match exactly across levels.
+//
+// gradients, if not null, receives the height gradient per level-0 cell:
+// n^2 d/dx values followed by n^2 d/dz values. They are central
+// differences over a one-sample apron of noise around the chunk, so they
+// match the neighbouring chunks' along shared borders.
+HeightRange generateChunkHeightmap(float* heightmap, float* gradients, ChunkCoord coord,
+                                   const GeneratorParams& params, int level);
+
+// World-space bounds of a chunk whose heights span range
+AABB chunkBounds(ChunkCoord coord, HeightRange range, float heightScale);
+
+// Normals are encoded for this height scale. An encoded normal keeps the
+// slope, -n.xz / n.y, so the shader rescales it to the live height scale
+// and vertices never depend on it.
+constexpr float CHUNK_NORMAL_SCALE = 100.0f;
+
+// Fills chunkLodVerts(lod.level)^2 compact vertices from a heightmap and
+// gradients of the same level, laid out as generateChunkHeightmap() writes
+// them. Normals are the gradients scaled by CHUNK_NORMAL_SCALE, odd
+// vertices on lod.coarserEdges are snapped to the coarser neighbour's edge.
+void buildChunkVertices(ChunkVertex* vertices, const float* heightmap,
+                        const float* gradients, ChunkLod lod);
+
+// Ends a triangle strip in the chunk index buffer
+constexpr uint16_t CHUNK_RESTART_INDEX = 0xFFFF;
+
+// Quads per strip. Rows are split into bands this narrow so a strip and
+// the row it shares with the previous strip (18 vertices) fit a 24-entry
+// post-transform cache. Wider bands fall off a cliff to ~1 shade/triangle.
+constexpr int CHUNK_STRIP_BAND = 8;
+
+// Triangle strips with primitive restart for a verticesPerSide^2 grid.
+// Every chunk of that size shares the result, winding matches the old
+// triangle list (counter-clockwise seen from above).
+void buildChunkIndices(std::vector<uint16_t>& indices, int verticesPerSide);
@@ -0,0 +1,50 @@
+#include "chunkLod.h"
+#include "const.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+int chunkLodVerts(int level) {
+    return (CHUNK_SIZE >> level) + 1;
+}
+
+int chunkLodStep(int level) {
+    return 1 << level;
+}
+
+ChunkCoord chunkAt(const glm::vec3& worldPos) {
+    return {
+        (int)std::floor(worldPos.x / (CHUNK_SIZE * CELL_SIZE)),
+        (int)std::floor(worldPos.z / (CHUNK_SIZE * CELL_SIZE))
+    };
+}
+
+int chunkLodLevel(ChunkCoord chunk, ChunkCoord camera, const LodSettings& settings) {
+    int ring = std::max(abs(chunk.x - camera.x), abs(chunk.z - camera.z));
+    int limit = std::max(1, settings.fullDetailRadius);
+
+    int level = 0;
+    while (ring > limit && level < settings.maxLevel) {
+        limit *= 2;
+        level++;
+    }
+    return std::min(level, MAX_CHUNK_LOD);
+}
+
+ChunkLod selectChunkLod(ChunkCoord chunk, const glm::vec3& cameraPos, const LodSettings& settings) {
+    ChunkCoord camera = chunkAt(cameraPos);
+
+    ChunkLod lod;
+    lod.level = chunkLodLevel(chunk, camera, settings);
+
+    auto coarser = [&](int dx, int dz) {
+        return chunkLodLevel({ chunk.x + dx, chunk.z + dz }, camera, settings) > lod.level;
+    };
+
+    if (coarser(-1, 0)) lod.coarserEdges |= EDGE_NEG_X;
+    if (coarser(1, 0))  lod.coarserEdges |= EDGE_POS_X;
+    if (coarser(0, -1)) lod.coarserEdges |= EDGE_NEG_Z;
+    if (coarser(0, 1))  lod.coarserEdges |= EDGE_POS_Z;
+
+    return lod;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include "chunkCoord.h"
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// Edges of a chunk whose neighbour is one level coarser. Odd vertices
+// along those edges are snapped onto the neighbour's edge line so the two
+// meshes meet without cracks.
+enum ChunkEdge : uint8_t {
+    EDGE_NEG_X = 1 << 0,
+    EDGE_POS_X = 1 << 1,
+    EDGE_NEG_Z = 1 << 2,
+    EDGE_POS_Z = 1 << 3
+};
+
+struct ChunkLod {
+    int level = 0;              // grid step is 1 << level cells
+    uint8_t coarserEdges = 0;   // ChunkEdge mask
+
+    bool operator==(const ChunkLod& o) const {
+        return level == o.level && coarserEdges == o.coarserEdges;
+    }
+    bool operator!=(const ChunkLod& o) const { return !(*this == o); }
+};
+
+struct LodSettings {
+    // chunks within this many rings of the camera get full resolution,
+    // every doubling of the distance after that drops one level
+    int fullDetailRadius = 2;
+    int maxLevel = 4;
+};
+
+// Vertices per side and grid step of a level
+int chunkLodVerts(int level);
+int chunkLodStep(int level);
+
+// Chunk containing a world position
+ChunkCoord chunkAt(const glm::vec3& worldPos);
+
+// Ring (Chebyshev) distance levels: neighbouring chunks are at most one
+// ring apart, so their levels never differ by more than one.
+int chunkLodLevel(ChunkCoord chunk, ChunkCoord camera, const LodSettings& settings);
+
+ChunkLod selectChunkLod(ChunkCoord chunk, const glm::vec3& cameraPos, const LodSettings& settings);
@@ -0,0 +1,90 @@
+#include "chunkResidency.h"
+#include <algorithm>
+#include <cstdlib>
+
+static int ringDistance(ChunkCoord a, ChunkCoord b) {
+    return std::max(abs(a.x - b.x), abs(a.z - b.z));
+}
+
+void ChunkResidency::add(ChunkCoord coord, size_t cpuBytes, size_t gpuBytes) {
+    auto found = m_index.find(coord);
+    if (found != m_index.end()) {
+        // a rebuild at another LOD replaces the old chunk
+        Entry& e = *found->second;
+        m_stats.cpuBytes -= e.cpuBytes;
+        m_stats.gpuBytes -= e.gpuBytes;
+        e.cpuBytes = cpuBytes;
+        e.gpuBytes = gpuBytes;
+        m_lru.splice(m_lru.begin(), m_lru, found->second);
+    } else {
+        m_lru.push_front({ coord, cpuBytes, gpuBytes, true });
+        m_index.emplace(coord, m_lru.begin());
+    }
+
+    m_stats.cpuBytes += cpuBytes;
+    m_stats.gpuBytes += gpuBytes;
+    m_stats.resident = m_lru.size();
+}
+
+void ChunkResidency::remove(ChunkCoord coord) {
+    auto found = m_index.find(coord);
+    if (found == m_index.end()) return;
+
+    m_stats.cpuBytes -= found->second->cpuBytes;
+    m_stats.gpuBytes -= found->second->gpuBytes;
+    m_lru.erase(found->second);
+    m_index.erase(found);
+    m_stats.resident = m_lru.size();
+}
+
+void ChunkResidency::touch(ChunkCoord coord) {
+    auto found = m_index.find(coord);
+    if (found == m_index.end()) return;
+
+    Entry& e = *found->second;
+    if (!e.inView) {
+        e.inView = true;
+        m_stats.hits++;
+    }
+    m_lru.splice(m_lru.begin(), m_lru, found->second);
+}
+
+void ChunkResidency::evict(std::list<Entry>::iterator it, std::vector<ChunkCoord>& out) {
+    out.push_back(it->coord);
+    m_stats.cpuBytes -= it->cpuBytes;
+    m_stats.gpuBytes -= it->gpuBytes;
+    m_stats.evictions++;
+    m_index.erase(it->coord);
+    m_lru.erase(it);
+}
+
+void ChunkResidency::collectEvictions(ChunkCoord center, int viewRadius,
+                                      std::vector<ChunkCoord>& out) {
+    int keepRadius = viewRadius + budget.hysteresis;
+
+    for (auto it = m_lru.begin(); it != m_lru.end();) {
+        auto next = std::next(it);
+        int d = ringDistance(it->coord, center);
+        if (d > keepRadius) {
+            evict(it, out);
+        } else if (d > viewRadius) {
+            it->inView = false;
+        }
+        it = next;
+    }
+
+    auto overBudget = [&] {
+        return m_stats.cpuBytes > budget.cpuBytes || m_stats.gpuBytes > budget.gpuBytes;
+    };
+
+    // oldest first, in-view chunks sit at the front and are skipped
+    for (auto it = m_lru.end(); it != m_lru.begin() && overBudget();) {
+        --it;
+        if (it->inView) continue;
+
+        auto victim = it++;
+        evict(victim, out);
+    }
+
+    m_stats.resident = m_lru.size();
+}
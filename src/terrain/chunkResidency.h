@@ -0,0 +1,65 @@
+#pragma once
+#include "chunkCoord.h"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+struct ResidencyBudget {
+    size_t cpuBytes = size_t(128) << 20;
+    size_t gpuBytes = size_t(128) << 20;
+
+    // rings past the view radius a chunk may stay resident regardless of
+    // budget, crossing a border back and forth then reuses what was built
+    int hysteresis = 4;
+};
+
+struct ResidencyStats {
+    uint64_t hits = 0;          // chunk came back into view still resident
+    uint64_t misses = 0;        // chunk came into view and had to be built
+    uint64_t evictions = 0;
+    size_t cpuBytes = 0;
+    size_t gpuBytes = 0;
+    size_t resident = 0;
+};
+
+// Least-recently-used bookkeeping for built chunks. Owns no chunk data,
+// the caller frees whatever collectEvictions() hands back.
+class ChunkResidency {
+public:
+    ResidencyBudget budget;
+
+    // Inserts or resizes a chunk and marks it used
+    void add(ChunkCoord coord, size_t cpuBytes, size_t gpuBytes);
+    void remove(ChunkCoord coord);
+    bool contains(ChunkCoord coord) const { return m_index.count(coord) != 0; }
+
+    // Marks an in-view chunk used this frame
+    void touch(ChunkCoord coord);
+    void recordMiss() { m_stats.misses++; }
+
+    // Appends chunks to drop: everything past viewRadius + hysteresis, then
+    // the least recently used chunks outside viewRadius until both budgets
+    // are met. Chunks inside the view radius are never evicted.
+    void collectEvictions(ChunkCoord center, int viewRadius, std::vector<ChunkCoord>& out);
+
+    const ResidencyStats& stats() const { return m_stats; }
+
+private:
+    struct Entry {
+        ChunkCoord coord;
+        size_t cpuBytes;
+        size_t gpuBytes;
+        bool inView;
+    };
+
+    void evict(std::list<Entry>::iterator it, std::vector<ChunkCoord>& out);
+
+    // front is the most recently used
+    std::list<Entry> m_lru;
+    std::unordered_map<ChunkCoord,
+        std::list<Entry>::iterator,
+        ChunkCoordHash> m_index;
+    ResidencyStats m_stats;
+};
@@ -0,0 +1,20 @@
+#include "chunkSchedule.h"
+#include "const.h"
+#include <cmath>
+
+float chunkPriority(ChunkCoord chunk, const glm::vec3& cameraPos,
+                    const glm::vec3& cameraFront, float angleWeight) {
+    const float extent = float(CHUNK_SIZE) * CELL_SIZE;
+    glm::vec2 center((float(chunk.x) + 0.5f) * extent, (float(chunk.z) + 0.5f) * extent);
+    glm::vec2 toChunk = center - glm::vec2(cameraPos.x, cameraPos.z);
+    glm::vec2 front(cameraFront.x, cameraFront.z);
+
+    float dist = glm::length(toChunk);
+    float frontLen = glm::length(front);
+
+    // looking straight up or down, or standing on the chunk: distance only
+    if (dist < 1e-3f || frontLen < 1e-3f) return dist;
+
+    float cosAngle = glm::dot(toChunk, front) / (dist * frontLen);
+    return dist * (1.0f + angleWeight * (1.0f - cosAngle));
+}
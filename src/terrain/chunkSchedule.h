@@ -0,0 +1,48 @@
+#pragma once
+#include "chunkCoord.h"
+#include <cstdint>
+#include <glm/glm.hpp>
+
+struct ScheduleSettings {
+    // main-thread time per frame for uploading finished chunks; at least
+    // one upload always goes through so streaming can't stall
+    float budgetMs = 4.0f;
+
+    // a chunk straight behind the camera counts as 1 + 2 * angleWeight
+    // times farther away than one straight ahead
+    float angleWeight = 1.0f;
+
+    // builds handed to the worker pool ahead of time. Everything else
+    // waits in the schedule and is re-ranked every frame.
+    int jobsPerWorker = 2;
+
+    // the camera's motion is extrapolated this far ahead and chunks that
+    // would come into view on the way are built after every visible one.
+    // Never reaches past the residency hysteresis, which would evict them
+    // again. 0 turns prefetching off.
+    float prefetchSeconds = 1.5f;
+};
+
+struct ScheduleStats {
+    int waiting = 0;            // wanted builds not handed to the workers yet
+    int inFlight = 0;           // queued or running on the workers
+    int stale = 0;              // in view but built from older parameters
+    int uploads = 0;            // this frame
+    int deferred = 0;           // finished but left for a later frame
+    float budgetUsedMs = 0.0f;
+    float buildMs = 0.0f;       // worker time of the chunks finished since the last update
+};
+
+// Totals since the manager was created
+struct PrefetchStats {
+    uint64_t requested = 0;     // builds handed out ahead of the camera
+    uint64_t entered = 0;       // chunks that came into view
+    uint64_t ready = 0;         // of those, already resident at that point
+
+    float hitRate() const { return entered ? float(ready) / float(entered) : 0.0f; }
+};
+
+// Build order key, lower goes first: horizontal distance from the camera
+// to the chunk centre, stretched for chunks away from the view direction
+float chunkPriority(ChunkCoord chunk, const glm::vec3& cameraPos,
+                    const glm::vec3& cameraFront, float angleWeight);
@@ -1,7 +1,9 @@
 // const.h
 #pragma once
 
-constexpr int CHUNK_SIZE = 64;        // vertices per side
+constexpr int CHUNK_SIZE = 64;        // grid cells per side
+constexpr int CHUNK_VERTS = CHUNK_SIZE + 1; // vertices per side, edges are shared with neighbours
 constexpr float CELL_SIZE = 10.0f;     // world units per grid cell
 constexpr float NOISE_SCALE = 0.5f;
 
+constexpr int MAX_CHUNK_LOD = 4;      // coarsest level keeps CHUNK_SIZE >> 4 cells per side
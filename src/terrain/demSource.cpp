@@ -0,0 +1,152 @@
+#include "demSource.h"
+#include "chunkLod.h"
+#include "const.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+// SRTM marks missing samples with this
+constexpr int16_t HGT_VOID = -32768;
+
+bool DemSource::open(const std::string& path, const DemSettings& settings) {
+    m_file.close();
+    m_settings = settings;
+
+    if (!m_file.openRead(path)) {
+        std::cerr << "[DemSource] failed to map " << path << std::endl;
+        return false;
+    }
+
+    m_sampleBytes = settings.format == DemFormat::Float32 ? 4 : 2;
+    size_t samples = m_file.size() / size_t(m_sampleBytes);
+
+    if (settings.format == DemFormat::Hgt) {
+        // 1201^2 for 3 arc-second tiles, 3601^2 for 1 arc-second ones
+        int side = int(std::lround(std::sqrt(double(samples))));
+        if (size_t(side) * side * 2 != m_file.size()) {
+            std::cerr << "[DemSource] " << path << " is not a square .hgt tile" << std::endl;
+            m_file.close();
+            return false;
+        }
+        m_settings.width = side;
+        m_settings.height = side;
+    }
+
+    if (m_settings.width <= 0 || m_settings.height <= 0 ||
+        samples < size_t(m_settings.width) * m_settings.height) {
+        std::cerr << "[DemSource] " << path << " doesn't hold a "
+                  << m_settings.width << "x" << m_settings.height << " grid" << std::endl;
+        m_file.close();
+        return false;
+    }
+
+    if (!(m_settings.maxElevation > m_settings.minElevation)) {
+        std::cerr << "[DemSource] empty elevation range" << std::endl;
+        m_file.close();
+        return false;
+    }
+
+    m_offset = 0.5f * (m_settings.minElevation + m_settings.maxElevation);
+    m_invHalfRange = 2.0f / (m_settings.maxElevation - m_settings.minElevation);
+
+    // FNV-1a over everything that changes the heights
+    uint64_t h = 1469598103934665603ull;
+    auto mix = [&](uint32_t v) {
+        for (int i = 0; i < 4; i++) {
+            h ^= (v >> (i * 8)) & 0xff;
+            h *= 1099511628211ull;
+        }
+    };
+    uint32_t minBits, maxBits;
+    std::memcpy(&minBits, &m_settings.minElevation, sizeof(minBits));
+    std::memcpy(&maxBits, &m_settings.maxElevation, sizeof(maxBits));
+
+    for (char c : path) mix((uint32_t)(unsigned char)c);
+    mix((uint32_t)m_file.size());
+    mix((uint32_t)(uint64_t(m_file.size()) >> 32));
+    mix((uint32_t)m_settings.format);
+    mix((uint32_t)m_settings.width);
+    mix((uint32_t)m_settings.height);
+    mix(minBits);
+    mix(maxBits);
+    mix((uint32_t)CHUNK_SIZE);
+    m_hash = h;
+
+    return true;
+}
+
+float DemSource::sample(int x, int z) const {
+    x = std::clamp(x, 0, m_settings.width - 1);
+    z = std::clamp(z, 0, m_settings.height - 1);
+    const uint8_t* p = m_file.data()
+        + (size_t(z) * m_settings.width + size_t(x)) * size_t(m_sampleBytes);
+
+    // decoded byte by byte, so it doesn't matter what the host order is
+    float e = 0.0f;
+    switch (m_settings.format) {
+    case DemFormat::Raw16:
+        e = float(uint16_t(p[0] | (p[1] << 8)));
+        break;
+    case DemFormat::Float32: {
+        uint32_t bits = uint32_t(p[0]) | (uint32_t(p[1]) << 8)
+                      | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+        std::memcpy(&e, &bits, sizeof(e));
+        if (!std::isfinite(e)) e = 0.0f;
+        break;
+    }
+    case DemFormat::Hgt: {
+        int16_t v = int16_t((p[0] << 8) | p[1]);
+        e = v == HGT_VOID ? 0.0f : float(v);
+        break;
+    }
+    }
+
+    return std::clamp((e - m_offset) * m_invHalfRange, -1.0f, 1.0f);
+}
+
+HeightRange DemSource::fill(float* heightmap, float* gradients,
+                            ChunkCoord coord, int level) const {
+    const int n = chunkLodVerts(level);
+    const int step = chunkLodStep(level);
+
+    // world cell (0, 0) is the middle of the grid
+    const int x0 = coord.x * CHUNK_SIZE + m_settings.width / 2;
+    const int z0 = coord.z * CHUNK_SIZE + m_settings.height / 2;
+
+    HeightRange range{ 1.0f, -1.0f };
+
+    for (int z = 0; z < n; z++) {
+        int sz = z0 + z * step;
+        float* row = &heightmap[z * n];
+
+        for (int x = 0; x < n; x++) {
+            int sx = x0 + x * step;
+            float h = sample(sx, sz);
+            row[x] = h;
+            range.min = std::min(range.min, h);
+            range.max = std::max(range.max, h);
+
+            if (gradients) {
+                // central differences at full resolution, per level-0 cell
+                // like the noise gradients, whatever the chunk's level
+                gradients[z * n + x] = (sample(sx + 1, sz) - sample(sx - 1, sz)) * 0.5f;
+                gradients[n * n + z * n + x] = (sample(sx, sz + 1) - sample(sx, sz - 1)) * 0.5f;
+            }
+        }
+    }
+    return range;
+}
+
+DemFormat demFormatFromPath(const std::string& path) {
+    std::string ext;
+    size_t dot = path.find_last_of('.');
+    if (dot != std::string::npos) ext = path.substr(dot + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(),
+        [](unsigned char c) { return (char)std::tolower(c); });
+
+    if (ext == "hgt") return DemFormat::Hgt;
+    if (ext == "f32" || ext == "flt") return DemFormat::Float32;
+    return DemFormat::Raw16;
+}
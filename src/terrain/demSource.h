@@ -0,0 +1,59 @@
+#pragma once
+#include "heightmapSource.h"
+#include "util/mappedFile.h"
+#include <string>
+
+enum class DemFormat {
+    Raw16,      // unsigned 16-bit little-endian, row-major
+    Float32,    // 32-bit float little-endian, row-major
+    Hgt         // SRTM: square, signed 16-bit big-endian metres
+};
+
+struct DemSettings {
+    DemFormat format = DemFormat::Hgt;
+
+    // samples per side, .hgt tiles derive both from the file size
+    int width = 0;
+    int height = 0;
+
+    // elevations mapped onto [-1, 1], everything outside is clamped
+    float minElevation = -500.0f;
+    float maxElevation = 9000.0f;
+};
+
+// Heights from a digital elevation model. The file is mapped, never read
+// as a whole: a chunk only touches the rows under it, so opening is
+// instant and resident memory follows the view radius, not the dataset.
+//
+// One sample is one level-0 cell and the grid is centred on the world
+// origin. Chunks past the edge repeat the border samples.
+class DemSource : public HeightmapSource {
+public:
+    // Returns false if the file can't be mapped or is smaller than the
+    // grid it's supposed to hold
+    bool open(const std::string& path, const DemSettings& settings);
+
+    HeightRange fill(float* heightmap, float* gradients,
+                     ChunkCoord coord, int level) const override;
+    uint64_t hash() const override { return m_hash; }
+
+    // reading the mapping is as cheap as reading the tile pack
+    bool cacheable() const override { return false; }
+
+    int width() const { return m_settings.width; }
+    int height() const { return m_settings.height; }
+
+private:
+    // Normalised height of a sample, clamped to the grid
+    float sample(int x, int z) const;
+
+    MappedFile m_file;
+    DemSettings m_settings;
+    int m_sampleBytes = 2;
+    float m_offset = 0.0f;
+    float m_invHalfRange = 1.0f;
+    uint64_t m_hash = 0;
+};
+
+// Guesses the format from the extension: .hgt, .f32 or raw 16-bit
+DemFormat demFormatFromPath(const std::string& path);
@@ -0,0 +1,23 @@
+#include "gpuBackend.h"
+
+void NullGpuBackend::createArena(uint32_t slotCount, size_t slotBytes,
+                                 const uint16_t*, size_t indexCount) {
+    // vertices, indices and one RGBA32F slot texel each, like GLBackend
+    m_stats.allocatedBytes = slotCount * slotBytes
+        + indexCount * sizeof(uint16_t)
+        + slotCount * sizeof(glm::vec4);
+}
+
+void NullGpuBackend::destroyArena() {
+    m_stats.allocatedBytes = 0;
+}
+
+void NullGpuBackend::uploadSlot(int, const ChunkVertex*, int count, const ChunkSlotInfo&) {
+    m_stats.uploads++;
+    m_stats.uploadedBytes += size_t(count) * sizeof(ChunkVertex) + sizeof(glm::vec4);
+}
+
+void NullGpuBackend::drawChunks(const Shader&, const ChunkDrawList& list) {
+    m_stats.draws++;
+    m_stats.chunksDrawn += uint64_t(list.drawCount);
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "chunkGen.h"
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+class Shader;
+
+// Per-slot draw parameters, read by the vertex shader from a buffer
+// texture since a multi-draw can't change uniforms between chunks
+struct ChunkSlotInfo {
+    glm::vec3 origin;           // y is always 0 and not stored
+    int gridVerts;
+    float gridSpacing;
+};
+
+// One frame's visible chunks as parallel arrays, ready for a multi-draw
+struct ChunkDrawList {
+    const int* counts;          // strip indices per chunk
+    const void* const* offsets; // byte offsets into the index buffer
+    const int* baseVertices;
+    int drawCount;
+    float heightScale;
+};
+
+// Every GPU resource call chunk streaming makes. The viewer runs a
+// GLBackend, tools without a context run a NullGpuBackend.
+class GpuBackend {
+public:
+    virtual ~GpuBackend() = default;
+
+    // One vertex buffer of slotCount slots, the shared strip indices and
+    // a slot info texel per slot. Called once, before any upload.
+    virtual void createArena(uint32_t slotCount, size_t slotBytes,
+                             const uint16_t* indices, size_t indexCount) = 0;
+    virtual void destroyArena() = 0;
+
+    virtual void uploadSlot(int slot, const ChunkVertex* vertices, int count,
+                            const ChunkSlotInfo& info) = 0;
+
+    virtual void drawChunks(const Shader& shader, const ChunkDrawList& list) = 0;
+};
+
+struct GpuStats {
+    size_t allocatedBytes = 0;  // buffers currently created
+    uint64_t uploadedBytes = 0; // everything ever written
+    uint64_t uploads = 0;
+    uint64_t draws = 0;         // multi-draw calls
+    uint64_t chunksDrawn = 0;
+};
+
+// Touches no GPU, only counts the bytes a real backend would move
+class NullGpuBackend : public GpuBackend {
+public:
+    void createArena(uint32_t slotCount, size_t slotBytes,
+                     const uint16_t* indices, size_t indexCount) override;
+    void destroyArena() override;
+    void uploadSlot(int slot, const ChunkVertex* vertices, int count,
+                    const ChunkSlotInfo& info) override;
+    void drawChunks(const Shader& shader, const ChunkDrawList& list) override;
+
+    const GpuStats& stats() const { return m_stats; }
+
+private:
+    GpuStats m_stats;
+};
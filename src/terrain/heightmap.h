@@ -1,96 +1,111 @@
 #pragma once
 #include <cmath>
 #include <algorithm>
-
-inline float hash(int x, int y, int seed = 1337) {
-    int n = x + y * 57 + seed * 131;
-    n = (n << 13) ^ n;
-    return 1.0f - float((n * (n * n * 15731 + 789221) + 1376312589) & 0x7fffffff) / 1073741824.0f;
-}
-
-inline float fade(float t) {
-    return t * t * t * (t * (t * 6 - 15) + 10);
-}
-
-inline float lerp(float a, float b, float t) {
-    return a + t * (b - a);
-}
-
-inline float perlin(float x, float y, int seed) {
-    int x0 = std::floor(x);
-    int y0 = std::floor(y);
-    int x1 = x0 + 1;
-    int y1 = y0 + 1;
-
-    float sx = fade(x - x0);
-    float sy = fade(y - y0);
-
-    float n00 = hash(x0, y0, seed);
-    float n10 = hash(x1, y0, seed);
-    float n01 = hash(x0, y1, seed);
-    float n11 = hash(x1, y1, seed);
-
-    float ix0 = lerp(n00, n10, sx);
-    float ix1 = lerp(n01, n11, sx);
-    return lerp(ix0, ix1, sy);
+#include <vector>
+#include "noise.h"
+#include "util/parallel.h"
+
+// rows per parallel work item, enough to amortise the per-band scratch
+constexpr size_t HEIGHTMAP_BAND_ROWS = 16;
+
+// Voronoi feature points for a width x height map, hashed once for the
+// whole map instead of 18 hashes per sample
+inline VoronoiCells heightmapCells(int width, int height, float scale, int seed) {
+    VoronoiCells cells;
+    cells.build(0.0f, 0.0f,
+        float(width - 1) / scale * 0.5f, float(height - 1) / scale * 0.5f, seed + 999);
+    return cells;
 }
 
-inline float voronoi(float x, float y, int cell_count, int seed) {
-    int xi = std::floor(x);
-    int yi = std::floor(y);
-
-    float minDist = 1e10f;
-    for (int j = -1; j <= 1; ++j) {
-        for (int i = -1; i <= 1; ++i) {
-            int cx = xi + i;
-            int cy = yi + j;
+// Rows [rowBegin, rowEnd) of the map generateHeightmapCPU() produces,
+// bit-identical to it. heightmap is the full-size array, gradients only
+// covers the rows generated: (rowEnd - rowBegin) * width d/dx values
+// followed by as many d/dy values. cells come from heightmapCells() with
+// the same arguments.
+inline void generateHeightmapRowsCPU(
+    float* heightmap,
+    int width,
+    int height,
+    int rowBegin,
+    int rowEnd,
+    float scale,
+    int seed,
+    float mix_ratio,
+    const VoronoiCells& cells,
+    float* gradients = nullptr
+) {
+    std::vector<float> xs(width);
+    for (int x = 0; x < width; ++x) {
+        xs[x] = float(x) / scale;
+    }
 
-            float rx = hash(cx, cy, seed) * 0.5f + 0.5f;
-            float ry = hash(cx, cy, seed + 42) * 0.5f + 0.5f;
+    const size_t plane = size_t(rowEnd - rowBegin) * width;
+
+    // Bands of rows go to the worker pool. Every row is computed the same
+    // way whichever thread runs it, so the result is bit-identical for
+    // any thread count.
+    parallelFor(size_t(rowEnd - rowBegin), HEIGHTMAP_BAND_ROWS, [&](size_t bandBegin, size_t bandEnd) {
+        std::vector<float> fbm(width);
+        std::vector<float> fbmDx;
+        std::vector<float> fbmDy;
+        if (gradients) {
+            fbmDx.resize(width);
+            fbmDy.resize(width);
+        }
 
-            float dx = (cx + rx) - x;
-            float dy = (cy + ry) - y;
-            float dist = std::sqrt(dx * dx + dy * dy);
-            minDist = std::min(minDist, dist);
+        for (int y = rowBegin + int(bandBegin); y < rowBegin + int(bandEnd); ++y) {
+            float fy = float(y) / scale;
+            float* row = heightmap + size_t(y) * width;
+            float* rowDx = gradients ? gradients + size_t(y - rowBegin) * width : nullptr;
+            float* rowDy = gradients ? rowDx + plane : nullptr;
+
+            // Multi-octave Perlin noise, one row at a time
+            if (gradients) {
+                perlinFbmRowGrad(fbm.data(), fbmDx.data(), fbmDy.data(), xs.data(), width, fy, seed, 4);
+            } else {
+                perlinFbmRow(fbm.data(), xs.data(), width, fy, seed, 4);
+            }
+
+            for (int x = 0; x < width; ++x) {
+                float fx = xs[x];
+
+                // Voronoi distance field
+                NoiseSample v = gradients
+                    ? cells.distanceGrad(fx * 0.5f, fy * 0.5f)
+                    : NoiseSample{ cells.distance(fx * 0.5f, fy * 0.5f), 0.0f, 0.0f };
+
+                // Blend Perlin and Voronoi
+                float height_val = (1.0f - mix_ratio) * fbm[x] + mix_ratio * (1.0f - v.value * 2.0f);
+
+                if (gradients) {
+                    // the voronoi term runs at half frequency, both at 1 / scale
+                    bool clamped = height_val < -1.0f || height_val > 1.0f;
+                    float gx = (1.0f - mix_ratio) * fbmDx[x] - mix_ratio * v.dx;
+                    float gy = (1.0f - mix_ratio) * fbmDy[x] - mix_ratio * v.dy;
+                    rowDx[x] = clamped ? 0.0f : gx / scale;
+                    rowDy[x] = clamped ? 0.0f : gy / scale;
+                }
+
+                // Clamp to [-1, 1]
+                height_val = std::max(-1.0f, std::min(1.0f, height_val));
+                row[x] = height_val;
+            }
         }
-    }
-    return minDist;
+    });
 }
 
+// gradients, if not null, receives the analytic height gradient per
+// sample step: width * height d/dx values followed by as many d/dy values.
 inline void generateHeightmapCPU(
     float* heightmap,
     int width,
     int height,
     float scale,
     int seed,
-    float mix_ratio
+    float mix_ratio,
+    float* gradients = nullptr
 ) {
-    for (int idx = 0; idx < width * height; ++idx) {
-        int x = idx % width;
-        int y = idx / width;
-
-        float fx = x / scale;
-        float fy = y / scale;
-
-        // Multi-octave Perlin noise
-        float amp = 1.0f;
-        float freq = 1.0f;
-        float noise_sum = 0.0f;
-        for (int o = 0; o < 4; ++o) {
-            noise_sum += perlin(fx * freq, fy * freq, seed + o * 17) * amp;
-            amp *= 0.5f;
-            freq *= 2.0f;
-        }
-
-        // Voronoi distance field
-        float v = voronoi(fx * 0.5f, fy * 0.5f, 8, seed + 999);
-
-        // Blend Perlin and Voronoi
-        float height_val = (1.0f - mix_ratio) * noise_sum + mix_ratio * (1.0f - v * 2.0f);
-
-        // Clamp to [-1, 1]
-        height_val = std::max(-1.0f, std::min(1.0f, height_val));
-        heightmap[idx] = height_val;
-    }
+    VoronoiCells cells = heightmapCells(width, height, scale, seed);
+    generateHeightmapRowsCPU(heightmap, width, height, 0, height,
+        scale, seed, mix_ratio, cells, gradients);
 }
-
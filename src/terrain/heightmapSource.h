@@ -0,0 +1,40 @@
+#pragma once
+#include "chunkGen.h"
+#include <cstdint>
+
+// Where chunk heights come from. fill() runs on the chunk builder's
+// worker threads, several at once, so implementations must be safe to
+// call concurrently.
+class HeightmapSource {
+public:
+    virtual ~HeightmapSource() = default;
+
+    // Same contract as generateChunkHeightmap(), gradients included
+    virtual HeightRange fill(float* heightmap, float* gradients,
+                             ChunkCoord coord, int level) const = 0;
+
+    // Changes whenever fill() would return different heights. Chunks and
+    // cached tiles built under another hash are stale.
+    virtual uint64_t hash() const = 0;
+
+    // Whether finished tiles are worth keeping in the tile pack
+    virtual bool cacheable() const { return true; }
+};
+
+// The noise generator
+class ProceduralSource : public HeightmapSource {
+public:
+    explicit ProceduralSource(const GeneratorParams& params)
+        : m_params(params), m_hash(generatorHash(params)) {}
+
+    HeightRange fill(float* heightmap, float* gradients,
+                     ChunkCoord coord, int level) const override {
+        return generateChunkHeightmap(heightmap, gradients, coord, m_params, level);
+    }
+
+    uint64_t hash() const override { return m_hash; }
+
+private:
+    GeneratorParams m_params;
+    uint64_t m_hash;
+};
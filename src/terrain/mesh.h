@@ -2,63 +2,102 @@
 #include <cmath>
 #include <vector>
 #include <algorithm>
+#include "util/parallel.h"
+
+// rows per parallel work item
+constexpr size_t MESH_BAND_ROWS = 32;
 
 struct float3 { float x, y, z; };
-struct float2 { float x, y; };
 
-inline void generateMeshFromHeightmapCPU(
+// Interleaved layout of the TerrainMesh vertex buffer
+struct MeshVertex {
+    float3 position;
+    float3 normal;
+};
+static_assert(sizeof(MeshVertex) == 6 * sizeof(float), "MeshVertex must stay tightly packed");
+
+// Meshes rows [rowBegin, rowEnd) of the heightmap, vertices[0] is the
+// first vertex of rowBegin. Every vertex is written exactly once, so
+// vertices may point straight into a mapped GL buffer. gradients, if
+// given, are generateHeightmapRowsCPU()'s analytic ones for the same rows
+// and replace the finite differences, which clamp at the border.
+inline void generateMeshRowsCPU(
     const float* heightmap,
-    float3* vertices,
-    float3* normals,
-    float2* texcoords,
+    MeshVertex* vertices,
     int width,
     int height,
+    int rowBegin,
+    int rowEnd,
     float scaleX,
     float scaleY,
-    float heightScale
+    float heightScale,
+    const float* gradients = nullptr
 ) {
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            int idx = y * width + x;
-            float h = heightmap[idx];
+    const size_t plane = size_t(rowEnd - rowBegin) * width;
+    const float invX = heightScale / ((scaleX != 0.0f) ? scaleX : 1.0f);
+    const float invY = heightScale / ((scaleY != 0.0f) ? scaleY : 1.0f);
 
-            // vertex
-            vertices[idx].x = x * scaleX;
-            vertices[idx].y = h * heightScale;
-            vertices[idx].z = y * scaleY;
+    // rows only read their neighbours, so bands can run on any thread
+    parallelFor(size_t(rowEnd - rowBegin), MESH_BAND_ROWS, [&](size_t bandBegin, size_t bandEnd) {
+        for (int y = rowBegin + int(bandBegin); y < rowBegin + int(bandEnd); ++y) {
+            const float* row = heightmap + size_t(y) * width;
+            const float* rowD = heightmap + size_t(std::max(y - 1, 0)) * width;
+            const float* rowU = heightmap + size_t(std::min(y + 1, height - 1)) * width;
+            size_t base = size_t(y - rowBegin) * width;
+            MeshVertex* out = vertices + size_t(y - rowBegin) * width;
 
-            // texcoord
-            texcoords[idx].x = (width > 1)  ? float(x) / float(width - 1)  : 0.0f;
-            texcoords[idx].y = (height > 1) ? float(y) / float(height - 1) : 0.0f;
+            for (int x = 0; x < width; ++x) {
+                size_t idx = base + x;
+                float h = row[x];
 
-            // finite differences with clamping
-            int xm = std::max(x - 1, 0);
-            int xp = std::min(x + 1, width - 1);
-            int ym = std::max(y - 1, 0);
-            int yp = std::min(y + 1, height - 1);
+                // vertex
+                float3 p;
+                p.x = float(x) * scaleX;
+                p.y = h * heightScale;
+                p.z = float(y) * scaleY;
 
-            float hL = heightmap[y * width + xm];
-            float hR = heightmap[y * width + xp];
-            float hD = heightmap[ym * width + x];
-            float hU = heightmap[yp * width + x];
+                float dx, dz;
+                if (gradients) {
+                    dx = gradients[idx] * invX;
+                    dz = gradients[plane + idx] * invY;
+                } else {
+                    // finite differences with clamping
+                    int xm = std::max(x - 1, 0);
+                    int xp = std::min(x + 1, width - 1);
 
-            float dx = (hR - hL) * 0.5f * heightScale / ((scaleX != 0.0f) ? scaleX : 1.0f);
-            float dz = (hU - hD) * 0.5f * heightScale / ((scaleY != 0.0f) ? scaleY : 1.0f);
+                    dx = (row[xp] - row[xm]) * 0.5f * invX;
+                    dz = (rowU[x] - rowD[x]) * 0.5f * invY;
+                }
 
-            float3 n;
-            n.x = -dx;
-            n.y = 1.0f;
-            n.z = -dz;
+                float3 n;
+                n.x = -dx;
+                n.y = 1.0f;
+                n.z = -dz;
 
-            float len = std::sqrt(n.x*n.x + n.y*n.y + n.z*n.z);
-            if (len > 1e-8f) {
-                n.x /= len; n.y /= len; n.z /= len;
-            } else {
-                n.x = 0.0f; n.y = 1.0f; n.z = 0.0f;
-            }
+                float len = std::sqrt(n.x*n.x + n.y*n.y + n.z*n.z);
+                if (len > 1e-8f) {
+                    n.x /= len; n.y /= len; n.z /= len;
+                } else {
+                    n.x = 0.0f; n.y = 1.0f; n.z = 0.0f;
+                }
 
-            normals[idx] = n;
+                // one full store per vertex, no read-back from the mapping
+                out[x] = MeshVertex{ p, n };
+            }
         }
-    }
+    });
 }
 
+inline void generateMeshFromHeightmapCPU(
+    const float* heightmap,
+    MeshVertex* vertices,
+    int width,
+    int height,
+    float scaleX,
+    float scaleY,
+    float heightScale,
+    const float* gradients = nullptr
+) {
+    generateMeshRowsCPU(heightmap, vertices, width, height, 0, height,
+        scaleX, scaleY, heightScale, gradients);
+}
@@ -0,0 +1,376 @@
+#include "noise.h"
+#include <atomic>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define NOISE_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define NOISE_TARGET(t) __attribute__((target(t)))
+#else
+#define NOISE_TARGET(t)
+#endif
+
+void VoronoiCells::build(float x0, float y0, float x1, float y1, int seed) {
+    // one ring of neighbours around the sampled cells
+    m_cx0 = (int)std::floor(x0) - 1;
+    m_cy0 = (int)std::floor(y0) - 1;
+    m_width = (int)std::floor(x1) + 2 - m_cx0;
+    int rows = (int)std::floor(y1) + 2 - m_cy0;
+
+    m_points.resize(size_t(2) * m_width * rows);
+    for (int j = 0; j < rows; j++) {
+        for (int i = 0; i < m_width; i++) {
+            int cx = m_cx0 + i;
+            int cy = m_cy0 + j;
+
+            // same expressions as voronoi(), so distances match exactly
+            float rx = hash(cx, cy, seed) * 0.5f + 0.5f;
+            float ry = hash(cx, cy, seed + 42) * 0.5f + 0.5f;
+
+            float* p = &m_points[2 * (size_t(j) * m_width + i)];
+            p[0] = float(cx) + rx;
+            p[1] = float(cy) + ry;
+        }
+    }
+}
+
+// Every row kernel is a template over the octave count. Octaves > 0 fixes
+// the trip count so the octave loop unrolls and its constants fold, 0
+// takes the count at run time.
+
+// Grad additionally writes dx and dy, which may be null otherwise.
+
+template <int Octaves, bool Grad>
+static void fbmRowScalar(float* out, float* dx, float* dy,
+                         const float* xs, int count, float y, int seed, int octaves) {
+    for (int i = 0; i < count; i++) {
+        if constexpr (Grad) {
+            NoiseSample n;
+            if constexpr (Octaves > 0) {
+                n = fbmGrad<Octaves>(xs[i], y, seed);
+            } else {
+                n = fbmGrad(xs[i], y, seed, octaves);
+            }
+            out[i] = n.value;
+            dx[i] = n.dx;
+            dy[i] = n.dy;
+        } else if constexpr (Octaves > 0) {
+            out[i] = fbm<Octaves>(xs[i], y, seed);
+        } else {
+            out[i] = fbm(xs[i], y, seed, octaves);
+        }
+    }
+}
+
+#ifdef NOISE_X86
+
+// y * 57 + seed * 131 with the wrap-around the scalar hash relies on
+static inline int hashRowTerm(int y, int seed) {
+    return (int)((unsigned)y * 57u + (unsigned)seed * 131u);
+}
+
+NOISE_TARGET("sse4.1")
+static inline __m128 hash4(__m128i x, int rowTerm) {
+    __m128i n = _mm_add_epi32(x, _mm_set1_epi32(rowTerm));
+    n = _mm_xor_si128(_mm_slli_epi32(n, 13), n);
+
+    __m128i t = _mm_mullo_epi32(n, n);
+    t = _mm_mullo_epi32(t, _mm_set1_epi32(15731));
+    t = _mm_add_epi32(t, _mm_set1_epi32(789221));
+    t = _mm_mullo_epi32(n, t);
+    t = _mm_add_epi32(t, _mm_set1_epi32(1376312589));
+    t = _mm_and_si128(t, _mm_set1_epi32(0x7fffffff));
+
+    // dividing by 2^30 and multiplying by 2^-30 are both exact
+    __m128 f = _mm_mul_ps(_mm_cvtepi32_ps(t), _mm_set1_ps(1.0f / 1073741824.0f));
+    return _mm_sub_ps(_mm_set1_ps(1.0f), f);
+}
+
+NOISE_TARGET("sse4.1")
+static inline __m128 fade4(__m128 t) {
+    __m128 inner = _mm_sub_ps(_mm_mul_ps(t, _mm_set1_ps(6.0f)), _mm_set1_ps(15.0f));
+    inner = _mm_add_ps(_mm_mul_ps(t, inner), _mm_set1_ps(10.0f));
+    __m128 t3 = _mm_mul_ps(_mm_mul_ps(t, t), t);
+    return _mm_mul_ps(t3, inner);
+}
+
+NOISE_TARGET("sse4.1")
+static inline __m128 fadeDerivative4(__m128 t) {
+    __m128 inner = _mm_add_ps(_mm_mul_ps(t, _mm_sub_ps(t, _mm_set1_ps(2.0f))), _mm_set1_ps(1.0f));
+    return _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(_mm_set1_ps(30.0f), t), t), inner);
+}
+
+NOISE_TARGET("sse4.1")
+static inline __m128 lerp4(__m128 a, __m128 b, __m128 t) {
+    return _mm_add_ps(a, _mm_mul_ps(t, _mm_sub_ps(b, a)));
+}
+
+template <int Octaves, bool Grad>
+NOISE_TARGET("sse4.1")
+static void fbmRowSse41(float* out, float* dx, float* dy,
+                        const float* xs, int count, float y, int seed, int octaves) {
+    const int octaveCount = Octaves > 0 ? Octaves : octaves;
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_loadu_ps(xs + i);
+        __m128 h = _mm_setzero_ps();
+        __m128 gx = _mm_setzero_ps();
+        __m128 gy = _mm_setzero_ps();
+        float amp = 1.0f;
+        float freq = 1.0f;
+
+        for (int o = 0; o < octaveCount; o++) {
+            int s = seed + o * FbmSpec::seedStep;
+
+            // the row coordinate is shared, so its half runs scalar
+            float py = y * freq;
+            int y0 = (int)std::floor(py);
+            float ty = py - (float)y0;
+            __m128 sy = _mm_set1_ps(fade(ty));
+            int row0 = hashRowTerm(y0, s);
+            int row1 = hashRowTerm(y0 + 1, s);
+
+            __m128 px = _mm_mul_ps(x, _mm_set1_ps(freq));
+            __m128i x0 = _mm_cvttps_epi32(_mm_floor_ps(px));
+            __m128i x1 = _mm_add_epi32(x0, _mm_set1_epi32(1));
+            __m128 tx = _mm_sub_ps(px, _mm_cvtepi32_ps(x0));
+            __m128 sx = fade4(tx);
+
+            __m128 n00 = hash4(x0, row0);
+            __m128 n10 = hash4(x1, row0);
+            __m128 n01 = hash4(x0, row1);
+            __m128 n11 = hash4(x1, row1);
+
+            __m128 ix0 = lerp4(n00, n10, sx);
+            __m128 ix1 = lerp4(n01, n11, sx);
+            __m128 n = lerp4(ix0, ix1, sy);
+
+            h = _mm_add_ps(h, _mm_mul_ps(n, _mm_set1_ps(amp)));
+
+            if constexpr (Grad) {
+                __m128 scale = _mm_set1_ps(amp * freq);
+                __m128 ndx = _mm_mul_ps(fadeDerivative4(tx),
+                    lerp4(_mm_sub_ps(n10, n00), _mm_sub_ps(n11, n01), sy));
+                __m128 ndy = _mm_mul_ps(_mm_set1_ps(fadeDerivative(ty)), _mm_sub_ps(ix1, ix0));
+                gx = _mm_add_ps(gx, _mm_mul_ps(ndx, scale));
+                gy = _mm_add_ps(gy, _mm_mul_ps(ndy, scale));
+            }
+            amp *= 0.5f;
+            freq *= 2.0f;
+        }
+
+        _mm_storeu_ps(out + i, h);
+        if constexpr (Grad) {
+            _mm_storeu_ps(dx + i, gx);
+            _mm_storeu_ps(dy + i, gy);
+        }
+    }
+
+    if constexpr (Grad) {
+        fbmRowScalar<Octaves, Grad>(out + i, dx + i, dy + i, xs + i, count - i, y, seed, octaves);
+    } else {
+        fbmRowScalar<Octaves, Grad>(out + i, dx, dy, xs + i, count - i, y, seed, octaves);
+    }
+}
+
+NOISE_TARGET("avx2")
+static inline __m256 hash8(__m256i x, int rowTerm) {
+    __m256i n = _mm256_add_epi32(x, _mm256_set1_epi32(rowTerm));
+    n = _mm256_xor_si256(_mm256_slli_epi32(n, 13), n);
+
+    __m256i t = _mm256_mullo_epi32(n, n);
+    t = _mm256_mullo_epi32(t, _mm256_set1_epi32(15731));
+    t = _mm256_add_epi32(t, _mm256_set1_epi32(789221));
+    t = _mm256_mullo_epi32(n, t);
+    t = _mm256_add_epi32(t, _mm256_set1_epi32(1376312589));
+    t = _mm256_and_si256(t, _mm256_set1_epi32(0x7fffffff));
+
+    __m256 f = _mm256_mul_ps(_mm256_cvtepi32_ps(t), _mm256_set1_ps(1.0f / 1073741824.0f));
+    return _mm256_sub_ps(_mm256_set1_ps(1.0f), f);
+}
+
+NOISE_TARGET("avx2")
+static inline __m256 fade8(__m256 t) {
+    __m256 inner = _mm256_sub_ps(_mm256_mul_ps(t, _mm256_set1_ps(6.0f)), _mm256_set1_ps(15.0f));
+    inner = _mm256_add_ps(_mm256_mul_ps(t, inner), _mm256_set1_ps(10.0f));
+    __m256 t3 = _mm256_mul_ps(_mm256_mul_ps(t, t), t);
+    return _mm256_mul_ps(t3, inner);
+}
+
+NOISE_TARGET("avx2")
+static inline __m256 fadeDerivative8(__m256 t) {
+    __m256 inner = _mm256_add_ps(_mm256_mul_ps(t, _mm256_sub_ps(t, _mm256_set1_ps(2.0f))), _mm256_set1_ps(1.0f));
+    return _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(30.0f), t), t), inner);
+}
+
+NOISE_TARGET("avx2")
+static inline __m256 lerp8(__m256 a, __m256 b, __m256 t) {
+    return _mm256_add_ps(a, _mm256_mul_ps(t, _mm256_sub_ps(b, a)));
+}
+
+template <int Octaves, bool Grad>
+NOISE_TARGET("avx2")
+static void fbmRowAvx2(float* out, float* dx, float* dy,
+                       const float* xs, int count, float y, int seed, int octaves) {
+    const int octaveCount = Octaves > 0 ? Octaves : octaves;
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = _mm256_loadu_ps(xs + i);
+        __m256 h = _mm256_setzero_ps();
+        __m256 gx = _mm256_setzero_ps();
+        __m256 gy = _mm256_setzero_ps();
+        float amp = 1.0f;
+        float freq = 1.0f;
+
+        for (int o = 0; o < octaveCount; o++) {
+            int s = seed + o * FbmSpec::seedStep;
+
+            float py = y * freq;
+            int y0 = (int)std::floor(py);
+            float ty = py - (float)y0;
+            __m256 sy = _mm256_set1_ps(fade(ty));
+            int row0 = hashRowTerm(y0, s);
+            int row1 = hashRowTerm(y0 + 1, s);
+
+            __m256 px = _mm256_mul_ps(x, _mm256_set1_ps(freq));
+            __m256i x0 = _mm256_cvttps_epi32(_mm256_floor_ps(px));
+            __m256i x1 = _mm256_add_epi32(x0, _mm256_set1_epi32(1));
+            __m256 tx = _mm256_sub_ps(px, _mm256_cvtepi32_ps(x0));
+            __m256 sx = fade8(tx);
+
+            __m256 n00 = hash8(x0, row0);
+            __m256 n10 = hash8(x1, row0);
+            __m256 n01 = hash8(x0, row1);
+            __m256 n11 = hash8(x1, row1);
+
+            __m256 ix0 = lerp8(n00, n10, sx);
+            __m256 ix1 = lerp8(n01, n11, sx);
+            __m256 n = lerp8(ix0, ix1, sy);
+
+            h = _mm256_add_ps(h, _mm256_mul_ps(n, _mm256_set1_ps(amp)));
+
+            if constexpr (Grad) {
+                __m256 scale = _mm256_set1_ps(amp * freq);
+                __m256 ndx = _mm256_mul_ps(fadeDerivative8(tx),
+                    lerp8(_mm256_sub_ps(n10, n00), _mm256_sub_ps(n11, n01), sy));
+                __m256 ndy = _mm256_mul_ps(_mm256_set1_ps(fadeDerivative(ty)), _mm256_sub_ps(ix1, ix0));
+                gx = _mm256_add_ps(gx, _mm256_mul_ps(ndx, scale));
+                gy = _mm256_add_ps(gy, _mm256_mul_ps(ndy, scale));
+            }
+            amp *= 0.5f;
+            freq *= 2.0f;
+        }
+
+        _mm256_storeu_ps(out + i, h);
+        if constexpr (Grad) {
+            _mm256_storeu_ps(dx + i, gx);
+            _mm256_storeu_ps(dy + i, gy);
+        }
+    }
+
+    if constexpr (Grad) {
+        fbmRowSse41<Octaves, Grad>(out + i, dx + i, dy + i, xs + i, count - i, y, seed, octaves);
+    } else {
+        fbmRowSse41<Octaves, Grad>(out + i, dx, dy, xs + i, count - i, y, seed, octaves);
+    }
+}
+
+#ifdef _MSC_VER
+static bool cpuHasSse41() {
+    int r[4];
+    __cpuid(r, 1);
+    return (r[2] & (1 << 19)) != 0;
+}
+
+static bool cpuHasAvx2() {
+    int r[4];
+    __cpuid(r, 0);
+    if (r[0] < 7) return false;
+
+    // AVX state must be enabled by the OS as well
+    __cpuid(r, 1);
+    bool osxsave = (r[2] & (1 << 27)) != 0;
+    bool avx = (r[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) return false;
+
+    __cpuidex(r, 7, 0);
+    return (r[1] & (1 << 5)) != 0;
+}
+#else
+static bool cpuHasSse41() { return __builtin_cpu_supports("sse4.1"); }
+static bool cpuHasAvx2() { return __builtin_cpu_supports("avx2"); }
+#endif
+
+#endif // NOISE_X86
+
+NoiseSimd detectNoiseSimd() {
+#ifdef NOISE_X86
+    if (cpuHasAvx2()) return NoiseSimd::AVX2;
+    if (cpuHasSse41()) return NoiseSimd::SSE41;
+#endif
+    return NoiseSimd::Scalar;
+}
+
+static std::atomic<NoiseSimd>& activeSimd() {
+    static std::atomic<NoiseSimd> level{ detectNoiseSimd() };
+    return level;
+}
+
+NoiseSimd noiseSimd() {
+    return activeSimd().load(std::memory_order_relaxed);
+}
+
+void setNoiseSimd(NoiseSimd level) {
+    if ((int)level > (int)detectNoiseSimd()) level = detectNoiseSimd();
+    activeSimd().store(level, std::memory_order_relaxed);
+}
+
+const char* noiseSimdName(NoiseSimd level) {
+    switch (level) {
+    case NoiseSimd::AVX2:  return "avx2";
+    case NoiseSimd::SSE41: return "sse4.1";
+    default:               return "scalar";
+    }
+}
+
+using FbmRowKernel = void (*)(float*, float*, float*, const float*, int, float, int, int);
+
+template <int Octaves, bool Grad>
+static FbmRowKernel fbmRowKernel(NoiseSimd level) {
+    switch (level) {
+#ifdef NOISE_X86
+    case NoiseSimd::AVX2:  return fbmRowAvx2<Octaves, Grad>;
+    case NoiseSimd::SSE41: return fbmRowSse41<Octaves, Grad>;
+#endif
+    default:               return fbmRowScalar<Octaves, Grad>;
+    }
+}
+
+template <bool Grad, int... O>
+static FbmRowKernel specializedKernel(NoiseSimd level, int octaves,
+                                      std::integer_sequence<int, O...>) {
+    FbmRowKernel kernel = fbmRowKernel<0, Grad>(level);
+    ((octaves == O + 1 ? (void)(kernel = fbmRowKernel<O + 1, Grad>(level)) : (void)0), ...);
+    return kernel;
+}
+
+void perlinFbmRow(float* out, const float* xs, int count, float y, int seed, int octaves) {
+    FbmRowKernel kernel = specializedKernel<false>(noiseSimd(), octaves,
+        std::make_integer_sequence<int, MAX_SPECIALIZED_OCTAVES>{});
+    kernel(out, nullptr, nullptr, xs, count, y, seed, octaves);
+}
+
+void perlinFbmRowGrad(float* out, float* dx, float* dy,
+                      const float* xs, int count, float y, int seed, int octaves) {
+    FbmRowKernel kernel = specializedKernel<true>(noiseSimd(), octaves,
+        std::make_integer_sequence<int, MAX_SPECIALIZED_OCTAVES>{});
+    kernel(out, dx, dy, xs, count, y, seed, octaves);
+}
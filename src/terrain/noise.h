@@ -0,0 +1,324 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+// Value-noise building blocks shared by every terrain generator. All of
+// them are inline so the per-sample callers and the fBm templates below
+// fold constants through them.
+
+inline float hash(int x, int y, int seed = 1337) {
+    int n = x + y * 57 + seed * 131;
+    n = (n << 13) ^ n;
+    return 1.0f - float((n * (n * n * 15731 + 789221) + 1376312589) & 0x7fffffff) / 1073741824.0f;
+}
+
+inline float fade(float t) {
+    return t * t * t * (t * (t * 6 - 15) + 10);
+}
+
+// d/dt of fade()
+inline float fadeDerivative(float t) {
+    return 30.0f * t * t * (t * (t - 2.0f) + 1.0f);
+}
+
+inline float lerp(float a, float b, float t) {
+    return a + t * (b - a);
+}
+
+inline float perlin(float x, float y, int seed) {
+    int x0 = std::floor(x);
+    int y0 = std::floor(y);
+    int x1 = x0 + 1;
+    int y1 = y0 + 1;
+
+    float sx = fade(x - x0);
+    float sy = fade(y - y0);
+
+    float n00 = hash(x0, y0, seed);
+    float n10 = hash(x1, y0, seed);
+    float n01 = hash(x0, y1, seed);
+    float n11 = hash(x1, y1, seed);
+
+    float ix0 = lerp(n00, n10, sx);
+    float ix1 = lerp(n01, n11, sx);
+    return lerp(ix0, ix1, sy);
+}
+
+// Noise value with its analytic gradient
+struct NoiseSample {
+    float value;
+    float dx;
+    float dy;
+};
+
+// perlin() plus the derivative of the bilinear blend of faded weights.
+// The value is computed exactly as perlin() computes it.
+inline NoiseSample perlinGrad(float x, float y, int seed) {
+    int x0 = (int)std::floor(x);
+    int y0 = (int)std::floor(y);
+    int x1 = x0 + 1;
+    int y1 = y0 + 1;
+
+    float tx = x - float(x0);
+    float ty = y - float(y0);
+    float sx = fade(tx);
+    float sy = fade(ty);
+
+    float n00 = hash(x0, y0, seed);
+    float n10 = hash(x1, y0, seed);
+    float n01 = hash(x0, y1, seed);
+    float n11 = hash(x1, y1, seed);
+
+    float ix0 = lerp(n00, n10, sx);
+    float ix1 = lerp(n01, n11, sx);
+
+    return {
+        lerp(ix0, ix1, sy),
+        fadeDerivative(tx) * lerp(n10 - n00, n11 - n01, sy),
+        fadeDerivative(ty) * (ix1 - ix0)
+    };
+}
+
+// Distance to the nearest jittered feature point of the unit grid
+inline float voronoi(float x, float y, int cell_count, int seed) {
+    int xi = std::floor(x);
+    int yi = std::floor(y);
+
+    float minDist = 1e10f;
+    for (int j = -1; j <= 1; ++j) {
+        for (int i = -1; i <= 1; ++i) {
+            int cx = xi + i;
+            int cy = yi + j;
+
+            float rx = hash(cx, cy, seed) * 0.5f + 0.5f;
+            float ry = hash(cx, cy, seed + 42) * 0.5f + 0.5f;
+
+            float dx = (cx + rx) - x;
+            float dy = (cy + ry) - y;
+            float dist = std::sqrt(dx * dx + dy * dy);
+            minDist = std::min(minDist, dist);
+        }
+    }
+    return minDist;
+}
+
+// voronoi() with its gradient, the unit vector away from the nearest point
+inline NoiseSample voronoiGrad(float x, float y, int cell_count, int seed) {
+    int xi = (int)std::floor(x);
+    int yi = (int)std::floor(y);
+
+    NoiseSample best{ 1e10f, 0.0f, 0.0f };
+    for (int j = -1; j <= 1; ++j) {
+        for (int i = -1; i <= 1; ++i) {
+            int cx = xi + i;
+            int cy = yi + j;
+
+            float rx = hash(cx, cy, seed) * 0.5f + 0.5f;
+            float ry = hash(cx, cy, seed + 42) * 0.5f + 0.5f;
+
+            float dx = (float(cx) + rx) - x;
+            float dy = (float(cy) + ry) - y;
+            float dist = std::sqrt(dx * dx + dy * dy);
+            if (dist < best.value) {
+                float inv = dist > 0.0f ? 1.0f / dist : 0.0f;
+                best = { dist, -dx * inv, -dy * inv };
+            }
+        }
+    }
+    return best;
+}
+
+// The feature points voronoi() hashes for a rectangle of cells, computed
+// once and shared by every sample inside it. distance() returns exactly
+// what voronoi() returns for the same seed.
+class VoronoiCells {
+public:
+    // Covers samples with x in [x0, x1] and y in [y0, y1], voronoi space
+    void build(float x0, float y0, float x1, float y1, int seed);
+
+    float distance(float x, float y) const {
+        return nearest<false>(x, y).value;
+    }
+
+    // distance() with the voronoiGrad() gradient
+    NoiseSample distanceGrad(float x, float y) const {
+        return nearest<true>(x, y);
+    }
+
+private:
+    // std::floor is a libm call without SSE4.1, this is the same for any
+    // x that fits an int
+    static int floorInt(float x) {
+        int i = (int)x;
+        return i - (x < (float)i);
+    }
+
+    template <bool Grad>
+    NoiseSample nearest(float x, float y) const {
+        int xi = floorInt(x);
+        int yi = floorInt(y);
+
+        // compare squared distances, sqrt is monotonic so one at the end
+        // gives the same result
+        float bestSq = 1e20f;
+        float bestDx = 0.0f;
+        float bestDy = 0.0f;
+        for (int j = -1; j <= 1; ++j) {
+            const float* row = &m_points[2 * ((yi + j - m_cy0) * m_width + (xi - 1 - m_cx0))];
+            for (int i = 0; i < 3; ++i) {
+                float dx = row[2 * i] - x;
+                float dy = row[2 * i + 1] - y;
+                float sq = dx * dx + dy * dy;
+
+                // selects rather than a branch, the winner is unpredictable
+                bool closer = sq < bestSq;
+                bestSq = closer ? sq : bestSq;
+                if constexpr (Grad) {
+                    bestDx = closer ? dx : bestDx;
+                    bestDy = closer ? dy : bestDy;
+                }
+            }
+        }
+
+        float dist = std::sqrt(bestSq);
+        if constexpr (Grad) {
+            float inv = dist > 0.0f ? 1.0f / dist : 0.0f;
+            return { dist, -bestDx * inv, -bestDy * inv };
+        } else {
+            return { dist, 0.0f, 0.0f };
+        }
+    }
+
+    int m_cx0 = 0;
+    int m_cy0 = 0;
+    int m_width = 0;
+    std::vector<float> m_points;    // x, y per cell, row-major
+};
+
+// Shape of an fBm sum. Octave o samples perlin at lacunarity^o times the
+// input with seed + o * seedStep and weighs it by gain^o.
+struct FbmSpec {
+    static constexpr float lacunarity = 2.0f;
+    static constexpr float gain = 0.5f;
+    static constexpr int seedStep = 17;
+};
+
+constexpr float fbmPow(float base, int n) {
+    float r = 1.0f;
+    for (int i = 0; i < n; i++) r *= base;
+    return r;
+}
+
+// variable templates force the per-octave constants to compile time
+template <typename Spec, int O>
+inline constexpr float fbmFrequency = fbmPow(Spec::lacunarity, O);
+
+template <typename Spec, int O>
+inline constexpr float fbmAmplitude = fbmPow(Spec::gain, O);
+
+// Runtime-parameter fBm, the reference the specialised version matches
+inline float fbm(float x, float y, int seed, int octaves,
+                 float lacunarity = FbmSpec::lacunarity, float gain = FbmSpec::gain) {
+    float h = 0.0f;
+    float amp = 1.0f;
+    float freq = 1.0f;
+    for (int o = 0; o < octaves; o++) {
+        h += perlin(x * freq, y * freq, seed + o * FbmSpec::seedStep) * amp;
+        amp *= gain;
+        freq *= lacunarity;
+    }
+    return h;
+}
+
+// fbm() with its gradient, each octave's derivative scaled by its
+// frequency times amplitude
+inline NoiseSample fbmGrad(float x, float y, int seed, int octaves,
+                           float lacunarity = FbmSpec::lacunarity, float gain = FbmSpec::gain) {
+    NoiseSample h{ 0.0f, 0.0f, 0.0f };
+    float amp = 1.0f;
+    float freq = 1.0f;
+    for (int o = 0; o < octaves; o++) {
+        NoiseSample n = perlinGrad(x * freq, y * freq, seed + o * FbmSpec::seedStep);
+        h.value += n.value * amp;
+        h.dx += n.dx * (amp * freq);
+        h.dy += n.dy * (amp * freq);
+        amp *= gain;
+        freq *= lacunarity;
+    }
+    return h;
+}
+
+// fBm with the octave count and spec fixed at compile time. The octave
+// loop is a fold over constant frequencies and amplitudes, so nothing but
+// the perlin calls is left at run time. Frequencies and amplitudes are
+// built by the same repeated multiplication as fbm(), results are equal.
+template <int Octaves, typename Spec = FbmSpec>
+inline float fbm(float x, float y, int seed) {
+    static_assert(Octaves >= 1, "fBm needs at least one octave");
+
+    return [&]<int... O>(std::integer_sequence<int, O...>) {
+        float h = 0.0f;
+        ((h += perlin(x * fbmFrequency<Spec, O>,
+                      y * fbmFrequency<Spec, O>,
+                      seed + O * Spec::seedStep) * fbmAmplitude<Spec, O>), ...);
+        return h;
+    }(std::make_integer_sequence<int, Octaves>{});
+}
+
+template <int Octaves, typename Spec = FbmSpec>
+inline NoiseSample fbmGrad(float x, float y, int seed) {
+    static_assert(Octaves >= 1, "fBm needs at least one octave");
+
+    return [&]<int... O>(std::integer_sequence<int, O...>) {
+        NoiseSample h{ 0.0f, 0.0f, 0.0f };
+        auto octave = [&](NoiseSample n, float amp, float freq) {
+            h.value += n.value * amp;
+            h.dx += n.dx * (amp * freq);
+            h.dy += n.dy * (amp * freq);
+        };
+        (octave(perlinGrad(x * fbmFrequency<Spec, O>,
+                           y * fbmFrequency<Spec, O>,
+                           seed + O * Spec::seedStep),
+                fbmAmplitude<Spec, O>, fbmFrequency<Spec, O>), ...);
+        return h;
+    }(std::make_integer_sequence<int, Octaves>{});
+}
+
+// Batched multi-octave Perlin (fBm) over one row of samples.
+//
+// xs holds count sample x coordinates, y is shared by the whole row.
+// Same sum as fbm() with the default FbmSpec. Octave counts up to
+// MAX_SPECIALIZED_OCTAVES run kernels specialised for that count.
+//
+// The SSE4.1/AVX2 kernels perform exactly the scalar operation sequence
+// (integer hash with wrap-around, floor, quintic fade, lerps) so results
+// match perlin() bit for bit under the default build flags. If the scalar
+// reference is compiled with FMA contraction (e.g. -march=native) the two
+// can differ by a few ulp per octave, well below 1e-6 of the [-1, 1] range.
+void perlinFbmRow(float* out, const float* xs, int count, float y, int seed, int octaves);
+
+// perlinFbmRow() that also writes the analytic gradient with respect to x
+// and y, as fbmGrad() computes it. Values are identical to perlinFbmRow().
+void perlinFbmRowGrad(float* out, float* dx, float* dy,
+                      const float* xs, int count, float y, int seed, int octaves);
+
+constexpr int MAX_SPECIALIZED_OCTAVES = 8;
+
+enum class NoiseSimd {
+    Scalar,
+    SSE41,
+    AVX2
+};
+
+// Best kernel the running CPU supports
+NoiseSimd detectNoiseSimd();
+
+// Kernel perlinFbmRow currently dispatches to, detectNoiseSimd() by default
+NoiseSimd noiseSimd();
+
+// Forces a kernel, clamped to what the CPU supports. Meant for benchmarks.
+void setNoiseSimd(NoiseSimd level);
+
+const char* noiseSimdName(NoiseSimd level);
@@ -1,37 +1,54 @@
 #pragma once
 #include <vector>
-#include <glad/gl.h>
+#include <cstdint>
 #include <glm/glm.hpp>
+#include "chunkGen.h"
+#include "heightmapSource.h"
 
-struct ChunkCoord {
-    int x, z;
-    bool operator==(const ChunkCoord& o) const {
-        return x == o.x && z == o.z;
-    }
-};
-
-struct ChunkCoordHash {
-    size_t operator()(const ChunkCoord& c) const {
-        return (std::hash<int>()(c.x) << 1) ^ std::hash<int>()(c.z);
-    }
-};
+class ChunkArena;
 
 class TerrainChunk {
 public:
+    using Vertex = ChunkVertex;
+
     ChunkCoord coord;
+    ChunkLod lod;
+
+    // slot in the arena's vertex buffer, -1 until uploaded
+    ChunkArena* arena = nullptr;
+    int slot = -1;
 
-    GLuint vao = 0;
-    GLuint vbo = 0;
-    GLuint ebo = 0;
-    int indexCount = 0;
+    // HeightmapSource::hash() of the source the heights came from
+    uint64_t paramsHash = 0;
+    // worker time spent on the heightmap and mesh
+    float buildMs = 0.0f;
 
     std::vector<float> heightmap;
+    // d/dx then d/dz per sample, see generateChunkHeightmap()
+    std::vector<float> gradients;
+    HeightRange heightRange{ 0.0f, 0.0f };
 
-    TerrainChunk(ChunkCoord c);
+    // CPU mesh filled by buildMesh(), released once upload() has run.
+    // It and the heightmap are chunkLodVerts(lod.level)^2 samples.
+    std::vector<Vertex> vertices;
+
+    TerrainChunk(ChunkCoord c, ChunkLod l);
     ~TerrainChunk();
 
-    void generateHeightmap(int seed);
-    void buildMesh(float heightScale);
-    void draw() const;
-};
+    // CPU only, safe to call from a worker thread
+    void generateHeightmap(const HeightmapSource& source);
+    void buildMesh();
+    // meshes from samples owned by someone else, e.g. a mapped tile
+    void buildMesh(const float* heights, const float* grads);
+
+    // Must run on the thread that owns the GL context. Returns false if
+    // the arena has no free slot, the chunk keeps its vertices then.
+    bool upload(ChunkArena& arena);
 
+    // vertices store normalized heights, the height scale is a uniform
+    AABB bounds(float heightScale) const;
+
+    // Resident memory. The shared index buffer isn't counted.
+    size_t cpuBytes() const;
+    size_t gpuBytes() const;
+};
@@ -1,38 +1,301 @@
 #include "terrainManager.h"
 #include "const.h"
+#include "math/frustum.h"
+#include "util/log.h"
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstdlib>
 
-void TerrainManager::update(const glm::vec3& camPos) {
-    int cx = (int)floor(camPos.x / (CHUNK_SIZE * CELL_SIZE));
-    int cz = (int)floor(camPos.z / (CHUNK_SIZE * CELL_SIZE));
+TerrainManager::TerrainManager(std::unique_ptr<GpuBackend> backend)
+    : m_backend(std::move(backend)) {}
+
+TerrainManager::~TerrainManager() {
+    // chunks hand their slots back to the arena, let them go while it exists
+    m_finished.clear();
+    chunks.clear();
+}
+
+void TerrainManager::clearTileCache() {
+    if (!m_externalSource || m_externalSource->cacheable()) m_tileCache.reset(sourceHash());
+}
+
+bool TerrainManager::openTileCache(const std::string& path, uint32_t slotCount) {
+    return m_tileCache.open(path, generatorHash(m_params), slotCount);
+}
+
+void TerrainManager::setHeightmapSource(std::shared_ptr<const HeightmapSource> source) {
+    // the next update() notices the hash change and rebuilds what's in view
+    m_externalSource = std::move(source);
+}
+
+uint64_t TerrainManager::sourceHash() const {
+    return m_externalSource ? m_externalSource->hash() : generatorHash(m_params);
+}
+
+void TerrainManager::update(const glm::vec3& camPos, const glm::vec3& camFront,
+                            const glm::vec3& camVelocity) {
+    PROFILE_ZONE("TerrainManager::update");
+
+    bool first = !m_arena.isCreated();
+    if (first) {
+        // room for the whole view square and a replacement of each chunk
+        // in it even if the budget is smaller, rebuilt chunks need a free
+        // slot while the old ones are still drawn
+        int side = 2 * viewRadius + 1;
+        size_t slots = std::max(residency.budget.gpuBytes / ChunkArena::slotBytes(),
+                                2 * size_t(side) * side);
+        m_arena.create(*m_backend, (uint32_t)slots);
+    }
+
+    ChunkCoord cam = chunkAt(camPos);
+    int cx = cam.x;
+    int cz = cam.z;
+    ChunkCoord previous = m_center;
+    m_center = cam;
+
+    // how far ahead of the camera chunks are built, kept inside the
+    // hysteresis so they aren't evicted before the camera gets there
+    const float extent = float(CHUNK_SIZE) * CELL_SIZE;
+    glm::vec3 motion(camVelocity.x, 0.0f, camVelocity.z);
+    float speed = glm::length(motion);
+    float ahead = std::min(speed * schedule.prefetchSeconds,
+                           float(residency.budget.hysteresis) * extent);
+    int aheadRings = ahead > 0.0f ? (int)std::ceil(ahead / extent) : 0;
+
+    uint64_t hash = sourceHash();
+    if (hash != m_paramsHash || !m_source) {
+        m_paramsHash = hash;
+        if (m_externalSource) {
+            m_source = m_externalSource;
+        } else {
+            m_source = std::make_shared<ProceduralSource>(m_params);
+        }
+
+        // Not rebound here: slider drags change the hash every frame and a
+        // baked pack is worth keeping. clearTileCache() commits to new ones.
+
+        // chunks kept past the view radius aren't worth regenerating
+        for (auto it = chunks.begin(); it != chunks.end();) {
+            if (abs(it->first.x - cx) > viewRadius || abs(it->first.z - cz) > viewRadius) {
+                residency.remove(it->first);
+                it = chunks.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    m_builder.cancelOutside(cam, viewRadius + aheadRings);
+    uploadFinished(camPos, camFront);
+    if (!first && !(cam == previous)) countEntered(previous, cam);
+
+    // Everything in view that needs a build. Holes come first, chunks that
+    // only have the wrong LOD or stale parameters stay visible meanwhile.
+    m_candidates.clear();
+    scheduleStats.stale = 0;
 
     for (int dz = -viewRadius; dz <= viewRadius; dz++) {
         for (int dx = -viewRadius; dx <= viewRadius; dx++) {
             ChunkCoord cc{ cx + dx, cz + dz };
+            ChunkLod lod = selectChunkLod(cc, camPos, lodSettings);
+
+            auto it = chunks.find(cc);
+            bool missing = it == chunks.end();
+            if (!missing) {
+                residency.touch(cc);
 
-            if (chunks.find(cc) == chunks.end()) {
-                auto chunk = std::make_unique<TerrainChunk>(cc);
-                chunk->generateHeightmap(m_seed);
-                chunk->buildMesh(m_scale);
-                chunks.emplace(cc, std::move(chunk));
+                bool stale = it->second->paramsHash != m_paramsHash;
+                if (stale) scheduleStats.stale++;
+                if (!stale && it->second->lod == lod) continue;
             }
+            // built already, waiting for its upload
+            if (m_deferred.count(cc)) continue;
+
+            m_candidates.push_back({ cc, lod, missing, false,
+                chunkPriority(cc, camPos, camFront, schedule.angleWeight) });
         }
     }
 
-    for (auto it = chunks.begin(); it != chunks.end();) {
-        int dx = it->first.x - cx;
-        int dz = it->first.z - cz;
-        if (abs(dx) > viewRadius || abs(dz) > viewRadius) {
-            it = chunks.erase(it);
-        } else {
-            ++it;
+    if (ahead > 0.0f) addPrefetchCandidates(camPos, motion / speed, ahead);
+
+    std::sort(m_candidates.begin(), m_candidates.end(),
+        [](const BuildCandidate& a, const BuildCandidate& b) {
+            if (a.prefetch != b.prefetch) return b.prefetch;
+            if (a.missing != b.missing) return a.missing;
+            return a.priority < b.priority;
+        });
+
+    // Only a few jobs are handed over at a time, the rest is re-ranked next
+    // frame so turning or flying on reorders what gets built
+    int limit = schedule.jobsPerWorker * (int)m_builder.workerCount();
+    int inFlight = (int)m_builder.pendingCount();
+    int waiting = 0;
+
+    for (const BuildCandidate& c : m_candidates) {
+        if (m_builder.isPending(c.coord)) continue;
+        if (inFlight >= limit) {
+            waiting++;
+            continue;
         }
+
+        // a pack holding other parameters misses and ignores the writes
+        bool cache = m_source->cacheable() && m_tileCache.isOpen();
+        m_builder.request(c.coord, c.lod, m_source, cache ? &m_tileCache : nullptr);
+        if (c.prefetch) {
+            prefetchStats.requested++;
+        } else if (c.missing) {
+            residency.recordMiss();
+        }
+        inFlight++;
+    }
+
+    scheduleStats.waiting = waiting;
+    scheduleStats.inFlight = inFlight;
+
+    m_evicted.clear();
+    residency.collectEvictions(cam, viewRadius, m_evicted);
+    for (ChunkCoord cc : m_evicted) {
+        chunks.erase(cc);
     }
 }
 
-void TerrainManager::draw() const {
-    for (auto& [_, chunk] : chunks) {
-        chunk->draw();
+void TerrainManager::addPrefetchCandidates(const glm::vec3& camPos, const glm::vec3& direction,
+                                           float distance) {
+    ChunkCoord cam = chunkAt(camPos);
+    m_prefetchSeen.clear();
+
+    // walk the path in half-chunk steps, every view square along it adds
+    // the chunks the current one doesn't have
+    const float extent = float(CHUNK_SIZE) * CELL_SIZE;
+    int steps = (int)std::ceil(distance / (0.5f * extent));
+    ChunkCoord last = cam;
+
+    for (int i = 1; i <= steps; i++) {
+        float along = distance * float(i) / float(steps);
+        glm::vec3 p = camPos + direction * along;
+        ChunkCoord center = chunkAt(p);
+        if (center == last) continue;
+        last = center;
+
+        for (int dz = -viewRadius; dz <= viewRadius; dz++) {
+            for (int dx = -viewRadius; dx <= viewRadius; dx++) {
+                ChunkCoord cc{ center.x + dx, center.z + dz };
+                if (abs(cc.x - cam.x) <= viewRadius && abs(cc.z - cam.z) <= viewRadius) continue;
+                if (chunks.count(cc) || m_deferred.count(cc)) continue;
+                if (!m_prefetchSeen.insert(cc).second) continue;
+
+                // LOD as seen from where the chunk comes into view, further
+                // along the path the nearest chunks are the ones needed first
+                m_candidates.push_back({ cc, selectChunkLod(cc, p, lodSettings), true, true,
+                    along + chunkPriority(cc, p, direction, schedule.angleWeight) });
+            }
+        }
     }
 }
 
+void TerrainManager::countEntered(ChunkCoord previous, ChunkCoord center) {
+    for (int dz = -viewRadius; dz <= viewRadius; dz++) {
+        for (int dx = -viewRadius; dx <= viewRadius; dx++) {
+            ChunkCoord cc{ center.x + dx, center.z + dz };
+            if (abs(cc.x - previous.x) <= viewRadius && abs(cc.z - previous.z) <= viewRadius) {
+                continue;
+            }
+            prefetchStats.entered++;
+            if (chunks.count(cc)) prefetchStats.ready++;
+        }
+    }
+}
+
+void TerrainManager::uploadFinished(const glm::vec3& camPos, const glm::vec3& camFront) {
+    PROFILE_ZONE("chunk upload");
+
+    using clock = std::chrono::steady_clock;
+    auto start = clock::now();
+
+    // Only the GL upload happens on this thread, best-ranked chunks first.
+    // Whatever doesn't fit the budget, or finds no free arena slot, waits
+    // for the next frame.
+    size_t collected = m_finished.size();
+    m_builder.collect(m_finished);
+
+    float buildMs = 0.0f;
+    for (size_t i = collected; i < m_finished.size(); i++) buildMs += m_finished[i]->buildMs;
+
+    auto priority = [&](const std::unique_ptr<TerrainChunk>& c) {
+        return chunkPriority(c->coord, camPos, camFront, schedule.angleWeight);
+    };
+    std::sort(m_finished.begin(), m_finished.end(),
+        [&](const auto& a, const auto& b) { return priority(a) < priority(b); });
+
+    int uploads = 0;
+    size_t waiting = 0;
+    float ms = 0.0f;
+
+    for (auto& chunk : m_finished) {
+        bool overBudget = uploads > 0 && ms > schedule.budgetMs;
+        if (overBudget || !chunk->upload(m_arena)) {
+            m_finished[waiting++] = std::move(chunk);
+            continue;
+        }
+        uploads++;
+
+        ChunkCoord cc = chunk->coord;
+        residency.add(cc, chunk->cpuBytes(), chunk->gpuBytes());
+        chunks.insert_or_assign(cc, std::move(chunk));
+
+        ms = std::chrono::duration<float, std::milli>(clock::now() - start).count();
+    }
+    m_finished.resize(waiting);
+
+    m_deferred.clear();
+    for (const auto& chunk : m_finished) m_deferred.insert(chunk->coord);
+
+    scheduleStats.uploads = uploads;
+    scheduleStats.deferred = (int)waiting;
+    scheduleStats.budgetUsedMs = ms;
+    scheduleStats.buildMs = buildMs;
+}
+
+void TerrainManager::draw(const Shader& shader, const Frustum& frustum) {
+    PROFILE_ZONE("TerrainManager::draw");
+
+    stats.chunksDrawn = 0;
+    stats.chunksCulled = 0;
+    stats.trianglesDrawn = 0;
+
+    if (!m_arena.isCreated()) return;
+
+    m_drawCounts.clear();
+    m_drawOffsets.clear();
+    m_drawBaseVertices.clear();
+
+    for (auto& [cc, chunk] : chunks) {
+        if (abs(cc.x - m_center.x) > viewRadius || abs(cc.z - m_center.z) > viewRadius) {
+            continue;
+        }
+        if (!frustum.intersects(chunk->bounds(m_scale))) {
+            stats.chunksCulled++;
+            continue;
+        }
+        stats.chunksDrawn++;
+
+        int level = chunk->lod.level;
+        int cells = CHUNK_SIZE >> level;
+        stats.trianglesDrawn += 2LL * cells * cells;
+
+        m_drawCounts.push_back(m_arena.indexCount(level));
+        m_drawOffsets.push_back(m_arena.indexOffset(level));
+        m_drawBaseVertices.push_back(chunk->slot * ChunkArena::SLOT_VERTS);
+    }
+
+    if (m_drawCounts.empty()) return;
+
+    ChunkDrawList list;
+    list.counts = m_drawCounts.data();
+    list.offsets = m_drawOffsets.data();
+    list.baseVertices = m_drawBaseVertices.data();
+    list.drawCount = (int)m_drawCounts.size();
+    list.heightScale = m_scale;
+    m_backend->drawChunks(shader, list);
+}
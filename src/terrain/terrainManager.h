@@ -1,20 +1,130 @@
 #pragma once
 #include "terrainChunk.h"
+#include "chunkArena.h"
+#include "chunkBuilder.h"
+#include "chunkLod.h"
+#include "chunkResidency.h"
+#include "chunkSchedule.h"
+#include "gpuBackend.h"
+#include "heightmapSource.h"
+#include "tilePack.h"
+#include "const.h"
 #include <unordered_map>
+#include <unordered_set>
 #include <memory>
+#include <string>
 #include <glm/glm.hpp>
 
+class Shader;
+struct Frustum;
+
+struct TerrainStats {
+    int chunksDrawn = 0;
+    int chunksCulled = 0;
+    long long trianglesDrawn = 0;
+};
+
 class TerrainManager {
 public:
-    int viewRadius = 4;
-    int m_seed = 1337;
+    int viewRadius = 16;
+    LodSettings lodSettings;
+
+    // chunks outside viewRadius stay around until these budgets or the
+    // hysteresis distance say otherwise
+    ChunkResidency residency;
+    // Missing, re-LODed and stale chunks are built in priority order
+    // within this frame budget
+    ScheduleSettings schedule;
+
+    // Editing m_params regenerates chunks in view through the schedule,
+    // the old ones stay on screen until their replacement is uploaded.
+    // m_scale is only a uniform and costs no rebuild.
+    GeneratorParams m_params;
     float m_scale = 100.0f;
 
     std::unordered_map<ChunkCoord,
         std::unique_ptr<TerrainChunk>,
         ChunkCoordHash> chunks;
 
-    void update(const glm::vec3& cameraPos);
-    void draw() const;
-};
+    // refreshed by every draw()
+    TerrainStats stats;
+    // refreshed by every update()
+    ScheduleStats scheduleStats;
+    PrefetchStats prefetchStats;
+
+    // Chunk buffers and draws go through backend, a NullGpuBackend runs
+    // the whole streaming path without a GPU
+    explicit TerrainManager(std::unique_ptr<GpuBackend> backend);
+    ~TerrainManager();
+
+    // Keeps generated heightmaps in a file so revisited and restarted
+    // sessions skip the noise. Optional, returns false if it can't be mapped.
+    bool openTileCache(const std::string& path, uint32_t slotCount = 16384);
+
+    // Replaces the noise with another source, e.g. a DemSource. m_params
+    // is ignored while one is set, nullptr goes back to the noise.
+    void setHeightmapSource(std::shared_ptr<const HeightmapSource> source);
+    TilePack::Stats tileCacheStats() const { return m_tileCache.stats(); }
+    // Editing m_params leaves the pack alone, it only serves the parameters
+    // it holds. This drops its tiles and starts caching the current ones.
+    void clearTileCache();
+    bool tileCacheCurrent() const { return m_tileCache.holds(m_paramsHash); }
+
+    // cameraVelocity is in world units per second, see Camera::velocity()
+    void update(const glm::vec3& cameraPos, const glm::vec3& cameraFront,
+                const glm::vec3& cameraVelocity = glm::vec3(0.0f));
+    // true once the last update() left nothing to build or upload
+    bool isIdle() const {
+        return scheduleStats.waiting == 0 && scheduleStats.inFlight == 0 && m_finished.empty();
+    }
+    void draw(const Shader& shader, const Frustum& frustum);
 
+private:
+    struct BuildCandidate {
+        ChunkCoord coord;
+        ChunkLod lod;
+        bool missing;
+        bool prefetch;          // outside the view, ahead of the camera
+        float priority;
+    };
+
+    void uploadFinished(const glm::vec3& cameraPos, const glm::vec3& cameraFront);
+    // Chunks that would come into view along the extrapolated camera path
+    void addPrefetchCandidates(const glm::vec3& cameraPos, const glm::vec3& direction,
+                               float distance);
+    void countEntered(ChunkCoord previous, ChunkCoord center);
+
+    // hash of whatever heights are current, m_params or the external source
+    uint64_t sourceHash() const;
+
+    uint64_t m_paramsHash = 0;
+    std::shared_ptr<const HeightmapSource> m_externalSource;
+    // what new jobs are built from, replaced when the hash changes
+    std::shared_ptr<const HeightmapSource> m_source;
+    std::vector<BuildCandidate> m_candidates;
+    std::unordered_set<ChunkCoord, ChunkCoordHash> m_prefetchSeen;
+
+    // declared before the arena, which releases its buffers through it
+    std::unique_ptr<GpuBackend> m_backend;
+    // vertex storage of every uploaded chunk, drawn with one multi-draw
+    ChunkArena m_arena;
+
+    // per-frame multi-draw arguments, kept to avoid reallocating
+    std::vector<int> m_drawCounts;
+    std::vector<const void*> m_drawOffsets;
+    std::vector<int> m_drawBaseVertices;
+
+    // camera chunk of the last update(), chunks kept past viewRadius
+    // aren't drawn
+    ChunkCoord m_center{ 0, 0 };
+    std::vector<ChunkCoord> m_evicted;
+
+    TilePack m_tileCache;
+
+    // declared after chunks and the cache so workers are joined before
+    // either goes away
+    ChunkBuilder m_builder;
+    std::vector<std::unique_ptr<TerrainChunk>> m_finished;
+    // coords of m_finished, the builder no longer counts them as pending
+    std::unordered_set<ChunkCoord, ChunkCoordHash> m_deferred;
+};
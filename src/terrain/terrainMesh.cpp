@@ -1,59 +1,27 @@
 #include "terrainMesh.h"
 #include "heightmap.h"
 #include "mesh.h"
+#include "util/log.h"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+
+// vertices per regeneration band, rows are rounded to fit
+constexpr size_t REGEN_BAND_VERTS = 1 << 16;
 
 TerrainMesh::TerrainMesh(int width, int depth) {
     m_width = width;
     m_depth = depth;
+    m_bandRows = int(std::max<size_t>(1, REGEN_BAND_VERTS / size_t(std::max(width, 1))));
 
     std::srand(std::time({}));
     m_seed = std::rand();
 
-    // generate a terrain heightmap
     m_heightmap.resize(width * depth);
 
-    generateHeightmapCPU(
-        m_heightmap.data(),
-        width, depth,
-        m_scale,
-        m_seed,
-        m_mix
-    ); 
-
-    // allocate CPU buffers
-    std::vector<float3> vertices(width * depth);
-    std::vector<float3> normals(width * depth);
-    std::vector<float2> texcoords(width * depth);
-
-    // generate mesh CPU version
-    generateMeshFromHeightmapCPU(
-        m_heightmap.data(),
-        vertices.data(),
-        normals.data(),
-        texcoords.data(),
-        width, depth,
-        1.0f, 1.0f, m_scale // scaleX, scaleY, heightScale
-    );
-
-    // flatten vertices and normals into OpenGL buffer (interleaved or positions only)
-    std::vector<float> vertexBuffer;
-    vertexBuffer.reserve(width * depth * 6); // 3 pos + 3 normal
-
-    for (int i = 0; i < vertices.size(); ++i) {
-        const auto& v = vertices[i];
-        const auto& n = normals[i];
-
-        vertexBuffer.push_back(v.x);
-        vertexBuffer.push_back(v.y);
-        vertexBuffer.push_back(v.z);
-
-        vertexBuffer.push_back(n.x);
-        vertexBuffer.push_back(n.y);
-        vertexBuffer.push_back(n.z);
-    }
-
     // generate indices
     std::vector<unsigned int> indices;
+    indices.reserve(size_t(std::max(width - 1, 0)) * std::max(depth - 1, 0) * 6);
     for (int y = 0; y < depth - 1; ++y) {
         for (int x = 0; x < width - 1; ++x) {
             int start = y * width + x;
@@ -69,75 +37,131 @@ TerrainMesh::TerrainMesh(int width, int depth) {
     }
     m_indexCount = indices.size();
 
-    // upload to OpenGL
-    glGenVertexArrays(1, &m_vao);
-    glGenBuffers(1, &m_vbo);
+    // upload to OpenGL, two vertex buffers sharing the indices so one can
+    // be rebuilt while the other is drawn
+    glGenVertexArrays(2, m_vao);
+    glGenBuffers(2, m_vbo);
     glGenBuffers(1, &m_ebo);
 
-    glBindVertexArray(m_vao);
-
-    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-    glBufferData(GL_ARRAY_BUFFER, vertexBuffer.size() * sizeof(float), vertexBuffer.data(), GL_STATIC_DRAW);
+    const GLsizeiptr bytes = GLsizeiptr(size_t(width) * depth * sizeof(MeshVertex));
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    for (int i = 0; i < 2; ++i) {
+        glBindVertexArray(m_vao[i]);
 
-    glEnableVertexAttribArray(0); // position
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+        // allocated once, rebuilds only write into the existing storage
+        glBindBuffer(GL_ARRAY_BUFFER, m_vbo[i]);
+        glBufferData(GL_ARRAY_BUFFER, bytes, nullptr, GL_STATIC_DRAW);
 
-    glEnableVertexAttribArray(1); // normal
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+        if (i == 0) {
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+        }
 
+        glEnableVertexAttribArray(0); // position
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void*)offsetof(MeshVertex, position));
 
+        glEnableVertexAttribArray(1); // normal
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void*)offsetof(MeshVertex, normal));
+    }
     glBindVertexArray(0);
+
+    // the first mesh is built in full before anything is drawn
+    m_cells = heightmapCells(m_width, m_depth, m_scale, m_seed);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo[m_front]);
+    for (int row = 0; row < m_depth; row += m_bandRows) {
+        buildRows(row, std::min(row + m_bandRows, m_depth));
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    m_nextRow = m_depth;
 }
 
 TerrainMesh::~TerrainMesh() {
-    glDeleteVertexArrays(1, &m_vao);
-    glDeleteBuffers(1, &m_vbo);
+    glDeleteVertexArrays(2, m_vao);
+    glDeleteBuffers(2, m_vbo);
     glDeleteBuffers(1, &m_ebo);
 }
 
 void TerrainMesh::regenerate() {
-    generateHeightmapCPU(
+    // a rebuild already running starts over with the new parameters
+    m_cells = heightmapCells(m_width, m_depth, m_scale, m_seed);
+    m_nextRow = 0;
+}
+
+bool TerrainMesh::update(float budgetMs) {
+    if (!isRegenerating()) return false;
+    PROFILE_ZONE("TerrainMesh::update");
+
+    using clock = std::chrono::steady_clock;
+    auto start = clock::now();
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo[1 - m_front]);
+    do {
+        int end = std::min(m_nextRow + m_bandRows, m_depth);
+        buildRows(m_nextRow, end);
+        m_nextRow = end;
+    } while (isRegenerating() &&
+             std::chrono::duration<float, std::milli>(clock::now() - start).count() < budgetMs);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // swap only once every row of the back buffer is current
+    if (!isRegenerating()) m_front = 1 - m_front;
+    return isRegenerating();
+}
+
+// Generates heightmap rows [rowBegin, rowEnd) and meshes them into the
+// bound GL_ARRAY_BUFFER. The vertices are written straight into the
+// mapped range; if the driver won't map it they go through one reusable
+// band-sized staging copy instead. The analytic gradients only live for
+// the band, the mesh keeps no copy of them.
+void TerrainMesh::buildRows(int rowBegin, int rowEnd) {
+    const size_t count = size_t(rowEnd - rowBegin) * m_width;
+    std::vector<float> gradients(2 * count);
+
+    generateHeightmapRowsCPU(
         m_heightmap.data(),
-        m_width,
-        m_depth,
+        m_width, m_depth,
+        rowBegin, rowEnd,
         m_scale,
         m_seed,
-        m_mix
+        m_mix,
+        m_cells,
+        gradients.data()
     );
 
-    std::vector<float3> vertices(m_width * m_depth);
-    std::vector<float3> normals(m_width * m_depth);
-    std::vector<float2> texcoords(m_width * m_depth);
-
-    generateMeshFromHeightmapCPU(
-        m_heightmap.data(),
-        vertices.data(),
-        normals.data(),
-        texcoords.data(),
-        m_width,
-        m_depth,
-        1.0f, 1.0f, m_scale
-    );
+    const GLintptr offset = GLintptr(size_t(rowBegin) * m_width * sizeof(MeshVertex));
+    const GLsizeiptr bytes = GLsizeiptr(count * sizeof(MeshVertex));
+
+    if (!m_useStaging) {
+        void* mapped = glMapBufferRange(GL_ARRAY_BUFFER, offset, bytes,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+        if (mapped) {
+            generateMeshRowsCPU(
+                m_heightmap.data(),
+                static_cast<MeshVertex*>(mapped),
+                m_width, m_depth,
+                rowBegin, rowEnd,
+                1.0f, 1.0f, m_scale, // scaleX, scaleY, heightScale
+                gradients.data()
+            );
+
+            // GL_FALSE means the store was lost, e.g. on a mode switch
+            if (glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE) return;
+        }
 
-    // update OpenGL buffer
-    std::vector<float> vertexBuffer;
-    vertexBuffer.reserve(m_width * m_depth * 6);
-    for (size_t i = 0; i < vertices.size(); ++i) {
-        vertexBuffer.push_back(vertices[i].x);
-        vertexBuffer.push_back(vertices[i].y);
-        vertexBuffer.push_back(vertices[i].z);
-
-        vertexBuffer.push_back(normals[i].x);
-        vertexBuffer.push_back(normals[i].y);
-        vertexBuffer.push_back(normals[i].z);
+        // don't keep trying a path that fails
+        m_useStaging = true;
     }
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-    glBufferData(GL_ARRAY_BUFFER, vertexBuffer.size() * sizeof(float), vertexBuffer.data(), GL_STATIC_DRAW);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    m_staging.resize(count);
+    generateMeshRowsCPU(
+        m_heightmap.data(),
+        m_staging.data(),
+        m_width, m_depth,
+        rowBegin, rowEnd,
+        1.0f, 1.0f, m_scale,
+        gradients.data()
+    );
+    glBufferSubData(GL_ARRAY_BUFFER, offset, bytes, m_staging.data());
 }
 
 void TerrainMesh::generateGrid(int width, int depth) {
@@ -170,13 +194,14 @@ void TerrainMesh::generateGrid(int width, int depth) {
     m_indexCount = indices.size();
 
     // OpenGL buffers
-    glGenVertexArrays(1, &m_vao);
-    glGenBuffers(1, &m_vbo);
+    glGenVertexArrays(1, &m_vao[0]);
+    glGenBuffers(1, &m_vbo[0]);
     glGenBuffers(1, &m_ebo);
+    m_front = 0;
 
-    glBindVertexArray(m_vao);
+    glBindVertexArray(m_vao[0]);
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo[0]);
     glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
@@ -189,7 +214,7 @@ void TerrainMesh::generateGrid(int width, int depth) {
 }
 
 void TerrainMesh::draw() const {
-    glBindVertexArray(m_vao);
+    glBindVertexArray(m_vao[m_front]);
     glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(m_indexCount), GL_UNSIGNED_INT, 0);
     glBindVertexArray(0);
 }
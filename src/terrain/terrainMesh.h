@@ -1,6 +1,8 @@
 #pragma once
 
 #include <glad/gl.h>
+#include "mesh.h"
+#include "noise.h"
 #include <vector>
 #include <cstdlib>
 #include <ctime>
@@ -12,18 +14,40 @@ public:
     ~TerrainMesh();
 
     void draw() const;
+
+    // Starts rebuilding the mesh from the current parameters into the
+    // back buffer. The current mesh keeps drawing until update() has
+    // built every row and swaps the buffers.
     void regenerate();
 
+    // Builds row bands until budgetMs is spent, at least one per call.
+    // Returns true while the rebuild is still running.
+    bool update(float budgetMs = 4.0f);
+    bool isRegenerating() const { return m_nextRow < m_depth; }
+
     void generateGrid(int width, int depth);
 
+    // run ahead of the drawn mesh while a rebuild is in progress
     std::vector<float> m_heightmap;
     float m_scale = 100.0f;
     int m_seed = 12348970;
     float m_mix = 0.6f;
     int m_width, m_depth;
-    unsigned int m_vao = 0;
-    unsigned int m_vbo = 0;
+    unsigned int m_vao[2] = { 0, 0 };
+    unsigned int m_vbo[2] = { 0, 0 };
     unsigned int m_ebo = 0;
+    int m_front = 0;                    // index of the buffer being drawn
     size_t m_indexCount = 0;
+
+private:
+    void buildRows(int rowBegin, int rowEnd);
+
+    VoronoiCells m_cells;
+    int m_bandRows = 1;
+    int m_nextRow = 0;
+
+    // only used when the driver refuses to map the vertex buffer
+    std::vector<MeshVertex> m_staging;
+    bool m_useStaging = false;
 };
 
@@ -0,0 +1,266 @@
+#include "tilePack.h"
+#include "const.h"
+#include <cstring>
+#include <iostream>
+#include <mutex>
+
+static constexpr char PACK_MAGIC[4] = { 'T', 'V', 'T', 'P' };
+static constexpr uint32_t PACK_VERSION = 3;
+static constexpr size_t PACK_PAGE = 4096;
+
+struct TilePack::PackHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t paramsHash;
+    uint32_t slotCount;
+    uint32_t slotBytes;
+    uint32_t indexCapacity;     // power of two
+    uint32_t usedSlots;
+    uint32_t chunkVerts;
+    uint32_t reserved[7];
+};
+
+struct TilePack::PackEntry {
+    int32_t x;
+    int32_t z;
+    int32_t level;              // -1 marks an empty entry
+    uint32_t slot;
+};
+
+struct TilePack::TileHeader {
+    float minHeight;
+    float maxHeight;
+    uint32_t samples;
+    uint32_t reserved;
+};
+
+static size_t roundUp(size_t v, size_t to) {
+    return (v + to - 1) / to * to;
+}
+
+static uint32_t slotBytesFor() {
+    // a height and two gradient components per sample
+    size_t bytes = 16 + 3 * sizeof(float) * CHUNK_VERTS * CHUNK_VERTS;
+    return (uint32_t)roundUp(bytes, PACK_PAGE);
+}
+
+static uint32_t indexCapacityFor(uint32_t slotCount) {
+    // keep the table at most half full
+    uint32_t cap = 1;
+    while (cap < slotCount * 2) cap <<= 1;
+    return cap;
+}
+
+TilePack::~TilePack() {
+    close();
+}
+
+TilePack::PackHeader* TilePack::header() const {
+    return reinterpret_cast<PackHeader*>(m_file.data());
+}
+
+TilePack::PackEntry* TilePack::entries() const {
+    return reinterpret_cast<PackEntry*>(m_file.data() + PACK_PAGE);
+}
+
+uint8_t* TilePack::slot(uint32_t index) const {
+    const PackHeader* h = header();
+    size_t indexBytes = roundUp(sizeof(PackEntry) * h->indexCapacity, PACK_PAGE);
+    return m_file.data() + PACK_PAGE + indexBytes + size_t(index) * h->slotBytes;
+}
+
+bool TilePack::open(const std::string& path, uint64_t paramsHash, uint32_t slotCount) {
+    static_assert(sizeof(PackHeader) == 64, "pack header layout");
+    static_assert(sizeof(PackEntry) == 16, "pack entry layout");
+    static_assert(sizeof(TileHeader) == 16, "tile header layout");
+
+    close();
+
+    uint32_t slotBytes = slotBytesFor();
+
+    // an existing pack keeps its size, e.g. one made by terrain_bake
+    {
+        MappedFile existing;
+        if (existing.openRead(path) && existing.size() >= sizeof(PackHeader)) {
+            PackHeader h;
+            std::memcpy(&h, existing.data(), sizeof(h));
+            if (std::memcmp(h.magic, PACK_MAGIC, 4) == 0
+                && h.version == PACK_VERSION
+                && h.slotBytes == slotBytes
+                && h.chunkVerts == (uint32_t)CHUNK_VERTS
+                && h.slotCount > 0) {
+                slotCount = h.slotCount;
+            }
+        }
+    }
+
+    uint32_t indexCapacity = indexCapacityFor(slotCount);
+    size_t size = PACK_PAGE
+        + roundUp(sizeof(PackEntry) * indexCapacity, PACK_PAGE)
+        + size_t(slotCount) * slotBytes;
+
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+    if (!m_file.openReadWrite(path, size)) {
+        std::cerr << "[TilePack] failed to map " << path << std::endl;
+        return false;
+    }
+
+    PackHeader* h = header();
+    bool compatible = std::memcmp(h->magic, PACK_MAGIC, 4) == 0
+        && h->version == PACK_VERSION
+        && h->slotCount == slotCount
+        && h->slotBytes == slotBytes
+        && h->indexCapacity == indexCapacity
+        && h->chunkVerts == (uint32_t)CHUNK_VERTS;
+
+    if (!compatible) {
+        std::memset(h, 0, sizeof(PackHeader));
+        std::memcpy(h->magic, PACK_MAGIC, 4);
+        h->version = PACK_VERSION;
+        h->slotCount = slotCount;
+        h->slotBytes = slotBytes;
+        h->indexCapacity = indexCapacity;
+        h->chunkVerts = CHUNK_VERTS;
+        h->paramsHash = paramsHash;
+        clear();
+    } else if (h->usedSlots > h->slotCount) {
+        std::cerr << "[TilePack] " << path << " is corrupt, starting over" << std::endl;
+        h->paramsHash = paramsHash;
+        clear();
+    } else if (h->paramsHash != paramsHash) {
+        // a baked pack is only dropped on purpose, through reset()
+        if (h->usedSlots == 0) {
+            h->paramsHash = paramsHash;
+        } else {
+            std::cerr << "[TilePack] " << path << " holds " << h->usedSlots
+                      << " tiles for other generator parameters, they are kept and miss"
+                      << std::endl;
+        }
+    }
+    return true;
+}
+
+void TilePack::close() {
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    m_file.flush();
+    m_file.close();
+}
+
+void TilePack::clear() {
+    PackHeader* h = header();
+    PackEntry* e = entries();
+    for (uint32_t i = 0; i < h->indexCapacity; i++) {
+        e[i] = { 0, 0, -1, 0 };
+    }
+    h->usedSlots = 0;
+}
+
+void TilePack::reset(uint64_t paramsHash) {
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    if (!isOpen()) return;
+
+    header()->paramsHash = paramsHash;
+    clear();
+}
+
+bool TilePack::holds(uint64_t paramsHash) const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return isOpen() && header()->paramsHash == paramsHash;
+}
+
+TilePack::PackEntry* TilePack::find(ChunkCoord coord, int level) const {
+    const PackHeader* h = header();
+    PackEntry* e = entries();
+    uint32_t mask = h->indexCapacity - 1;
+
+    uint32_t i = (uint32_t(coord.x) * 73856093u
+                ^ uint32_t(coord.z) * 19349663u
+                ^ uint32_t(level) * 83492791u) & mask;
+
+    // returns the matching entry or the empty one where it would go, the
+    // table is never more than half full unless the file is corrupt
+    for (uint32_t probe = 0; probe <= mask; probe++) {
+        PackEntry& entry = e[i];
+        if (entry.level < 0) return &entry;
+        if (entry.x == coord.x && entry.z == coord.z && entry.level == level) return &entry;
+        i = (i + 1) & mask;
+    }
+    return nullptr;
+}
+
+bool TilePack::read(ChunkCoord coord, int level, uint64_t paramsHash,
+                    const std::function<void(const float*, const float*, HeightRange)>& fn) {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+
+    if (!isOpen() || header()->paramsHash != paramsHash) {
+        m_misses++;
+        return false;
+    }
+
+    const PackEntry* entry = find(coord, level);
+    if (!entry || entry->level < 0 || entry->slot >= header()->slotCount) {
+        m_misses++;
+        return false;
+    }
+
+    const uint8_t* data = slot(entry->slot);
+    TileHeader tile;
+    std::memcpy(&tile, data, sizeof(tile));
+
+    // everything read from the file is checked before it's trusted
+    int n = chunkLodVerts(level);
+    if (tile.samples != uint32_t(n * n)) {
+        m_misses++;
+        return false;
+    }
+
+    const float* heights = reinterpret_cast<const float*>(data + sizeof(TileHeader));
+    m_hits++;
+    fn(heights, heights + tile.samples, HeightRange{ tile.minHeight, tile.maxHeight });
+    return true;
+}
+
+void TilePack::write(ChunkCoord coord, int level, uint64_t paramsHash,
+                     const float* heights, const float* gradients, HeightRange range) {
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+    if (!isOpen() || header()->paramsHash != paramsHash) return;
+
+    PackHeader* h = header();
+    PackEntry* entry = find(coord, level);
+
+    if (!entry || entry->level < 0 || entry->slot >= h->slotCount) {
+        if (!entry || h->usedSlots >= h->slotCount) {
+            // full: start over rather than track recency on disk
+            clear();
+            entry = find(coord, level);
+        }
+        *entry = { coord.x, coord.z, level, h->usedSlots++ };
+    }
+
+    int n = chunkLodVerts(level);
+    TileHeader tile{ range.min, range.max, uint32_t(n * n), 0 };
+
+    uint8_t* data = slot(entry->slot);
+    std::memcpy(data, &tile, sizeof(tile));
+    float* samples = reinterpret_cast<float*>(data + sizeof(TileHeader));
+    std::memcpy(samples, heights, sizeof(float) * n * n);
+    std::memcpy(samples + n * n, gradients, 2 * sizeof(float) * n * n);
+
+    m_writes++;
+}
+
+TilePack::Stats TilePack::stats() const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+
+    Stats s;
+    s.hits = m_hits.load();
+    s.misses = m_misses.load();
+    s.writes = m_writes.load();
+    if (isOpen()) {
+        s.usedSlots = header()->usedSlots;
+        s.slotCount = header()->slotCount;
+    }
+    return s;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include "chunkCoord.h"
+#include "chunkGen.h"
+#include "util/mappedFile.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <shared_mutex>
+#include <string>
+
+// Memory-mapped file of finished chunk heightmaps.
+//
+// Layout (native endianness):
+//   PackHeader                      one page
+//   PackEntry[indexCapacity]        open-addressing table keyed by (x, z, level)
+//   slot[slotCount]                 TileHeader, heights, d/dx, d/dz
+//
+// Slots are sized for a level-0 heightmap, coarser levels only touch the
+// first pages of theirs, which stay sparse on disk. A pack holds tiles for
+// one set of generator parameters, other parameters only miss, including
+// the ones it's opened with. Filling every slot or reset() clears it.
+class TilePack {
+public:
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t writes = 0;
+        uint32_t usedSlots = 0;
+        uint32_t slotCount = 0;
+    };
+
+    TilePack() = default;
+    ~TilePack();
+
+    TilePack(const TilePack&) = delete;
+    TilePack& operator=(const TilePack&) = delete;
+
+    // slotCount sizes a new pack, an existing compatible one keeps its own
+    bool open(const std::string& path, uint64_t paramsHash, uint32_t slotCount = 16384);
+    void close();
+    bool isOpen() const { return m_file.isOpen(); }
+
+    // Drops every tile and rebinds the pack to paramsHash
+    void reset(uint64_t paramsHash);
+    bool holds(uint64_t paramsHash) const;
+
+    // Calls fn with the mapped heights and gradients, laid out as
+    // generateChunkHeightmap() writes them, and their range while the tile
+    // is pinned. Nothing is copied. Returns false on a miss.
+    bool read(ChunkCoord coord, int level, uint64_t paramsHash,
+              const std::function<void(const float*, const float*, HeightRange)>& fn);
+
+    // Stores chunkLodVerts(level)^2 heights and their gradients. Ignored if
+    // paramsHash is stale.
+    void write(ChunkCoord coord, int level, uint64_t paramsHash,
+               const float* heights, const float* gradients, HeightRange range);
+
+    Stats stats() const;
+
+private:
+    struct PackHeader;
+    struct PackEntry;
+    struct TileHeader;
+
+    PackHeader* header() const;
+    PackEntry* entries() const;
+    uint8_t* slot(uint32_t index) const;
+
+    PackEntry* find(ChunkCoord coord, int level) const;
+    void clear();
+
+    MappedFile m_file;
+    mutable std::shared_mutex m_mutex;
+
+    std::atomic<uint64_t> m_hits{ 0 };
+    std::atomic<uint64_t> m_misses{ 0 };
+    std::atomic<uint64_t> m_writes{ 0 };
+};
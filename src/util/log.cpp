@@ -0,0 +1,256 @@
+#include "log.h"
+
+#if TERRAIN_PROFILE
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+
+// zones per thread before the oldest are overwritten
+constexpr uint64_t PROFILE_RING_EVENTS = 1 << 16;
+// readers stay this far behind the writer's wrap point
+constexpr uint64_t PROFILE_RING_SLACK = 1024;
+constexpr uint64_t PROFILE_FRAME_HISTORY = 1024;
+
+// Fields are relaxed atomics so a reader racing the writer sees old or new
+// values, never undefined behaviour. A torn event is possible right at the
+// wrap point, the slack keeps readers away from it.
+struct ProfileEvent {
+    std::atomic<const char*> name{ nullptr };
+    std::atomic<int64_t> start{ 0 };
+    std::atomic<int64_t> end{ 0 };
+};
+
+struct ProfileRing {
+    std::unique_ptr<ProfileEvent[]> events{ new ProfileEvent[PROFILE_RING_EVENTS] };
+    std::atomic<uint64_t> head{ 0 };
+    uint32_t tid = 0;
+    // guarded by the registry mutex
+    std::string threadName;
+    bool retired = false;       // its thread exited, the next new one reuses it
+};
+
+struct ProfileRegistry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ProfileRing>> rings;
+    uint32_t nextTid = 1;
+
+    // frame start times, written by the thread calling profileFrame()
+    std::atomic<int64_t> frames[PROFILE_FRAME_HISTORY] = {};
+    std::atomic<uint64_t> frameCount{ 0 };
+};
+
+static ProfileRegistry& registry() {
+    // never destroyed, worker threads may still record during exit
+    static ProfileRegistry* instance = new ProfileRegistry();
+    return *instance;
+}
+
+// Hands the ring back when its thread exits. Pools that are torn down and
+// recreated would otherwise leave a ring per thread they ever started.
+struct ThreadRing {
+    std::shared_ptr<ProfileRing> ring;
+
+    ~ThreadRing() {
+        if (!ring) return;
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        ring->retired = true;
+    }
+};
+
+static thread_local ThreadRing t_ring;
+
+static ProfileRing& threadRing() {
+    if (!t_ring.ring) {
+        ProfileRegistry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+
+        std::shared_ptr<ProfileRing> ring;
+        for (const auto& retired : r.rings) {
+            if (!retired->retired) continue;
+            // readers hold the mutex too, so none sees the old events go
+            ring = retired;
+            ring->retired = false;
+            ring->threadName.clear();
+            ring->head.store(0, std::memory_order_relaxed);
+            break;
+        }
+        if (!ring) {
+            ring = std::make_shared<ProfileRing>();
+            r.rings.push_back(ring);
+        }
+        ring->tid = r.nextTid++;
+        t_ring.ring = std::move(ring);
+    }
+    return *t_ring.ring;
+}
+
+int64_t profileNowNs() {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void profileRecord(const char* name, int64_t startNs, int64_t endNs) {
+    ProfileRing& ring = threadRing();
+    uint64_t h = ring.head.load(std::memory_order_relaxed);
+
+    ProfileEvent& e = ring.events[h & (PROFILE_RING_EVENTS - 1)];
+    e.name.store(name, std::memory_order_relaxed);
+    e.start.store(startNs, std::memory_order_relaxed);
+    e.end.store(endNs, std::memory_order_relaxed);
+
+    ring.head.store(h + 1, std::memory_order_release);
+}
+
+void profileFrame() {
+    ProfileRegistry& r = registry();
+    uint64_t count = r.frameCount.load(std::memory_order_relaxed);
+    r.frames[count % PROFILE_FRAME_HISTORY].store(profileNowNs(), std::memory_order_relaxed);
+    r.frameCount.store(count + 1, std::memory_order_release);
+}
+
+void profileThreadName(const char* name) {
+    ProfileRing& ring = threadRing();
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    ring.threadName = name;
+}
+
+// Start of the frame frames frames ago, or of the oldest one remembered
+static int64_t windowStart(int frames) {
+    ProfileRegistry& r = registry();
+    uint64_t count = r.frameCount.load(std::memory_order_acquire);
+    if (count == 0) return INT64_MIN;
+
+    uint64_t back = std::min<uint64_t>({ uint64_t(std::max(frames, 1)), count,
+                                         PROFILE_FRAME_HISTORY - 1 });
+    return r.frames[(count - back) % PROFILE_FRAME_HISTORY].load(std::memory_order_relaxed);
+}
+
+struct ProfileSnapshotEvent {
+    const char* name;
+    int64_t start;
+    int64_t end;
+    uint32_t tid;
+};
+
+// Copies every zone that started at or after since out of the rings
+static void snapshot(int64_t since, std::vector<ProfileSnapshotEvent>& out,
+                     std::vector<std::pair<uint32_t, std::string>>* threads) {
+    ProfileRegistry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+
+    for (const auto& ring : r.rings) {
+        if (threads && !ring->threadName.empty()) {
+            threads->push_back({ ring->tid, ring->threadName });
+        }
+
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        uint64_t keep = PROFILE_RING_EVENTS - PROFILE_RING_SLACK;
+        uint64_t first = head > keep ? head - keep : 0;
+
+        for (uint64_t i = first; i < head; i++) {
+            const ProfileEvent& e = ring->events[i & (PROFILE_RING_EVENTS - 1)];
+            int64_t start = e.start.load(std::memory_order_relaxed);
+            if (start < since) continue;
+            out.push_back({ e.name.load(std::memory_order_relaxed), start,
+                            e.end.load(std::memory_order_relaxed), ring->tid });
+        }
+    }
+}
+
+void profileStats(std::vector<ProfileZoneStats>& out, int frames) {
+    out.clear();
+
+    std::vector<ProfileSnapshotEvent> events;
+    snapshot(windowStart(frames), events, nullptr);
+
+    std::map<std::string, std::vector<double>> byName;
+    for (const auto& e : events) {
+        if (e.name) byName[e.name].push_back(double(e.end - e.start) * 1e-6);
+    }
+
+    for (auto& [name, ms] : byName) {
+        std::sort(ms.begin(), ms.end());
+
+        // nearest rank
+        auto percentile = [&](double p) {
+            size_t rank = size_t(std::ceil(p * double(ms.size())));
+            return ms[std::min(ms.size() - 1, rank > 0 ? rank - 1 : 0)];
+        };
+        out.push_back({ name, uint32_t(ms.size()),
+                        percentile(0.50), percentile(0.95), percentile(0.99) });
+    }
+}
+
+static void writeJsonString(std::ostream& os, const char* s) {
+    os << '"';
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') os << '\\';
+        os << *s;
+    }
+    os << '"';
+}
+
+bool profileExportTrace(const std::string& path, int frames) {
+    std::vector<ProfileSnapshotEvent> events;
+    std::vector<std::pair<uint32_t, std::string>> threads;
+    int64_t since = windowStart(frames);
+    snapshot(since, events, &threads);
+
+    std::ofstream file(path);
+    if (!file) return false;
+
+    // trace timestamps are microseconds from the first event
+    int64_t origin = INT64_MAX;
+    for (const auto& e : events) origin = std::min(origin, e.start);
+    if (events.empty()) origin = 0;
+
+    auto us = [&](int64_t ns) { return double(ns - origin) * 1e-3; };
+
+    file << "{\"traceEvents\":[\n";
+    bool first = true;
+    auto separator = [&] {
+        if (!first) file << ",\n";
+        first = false;
+    };
+
+    for (const auto& [tid, name] : threads) {
+        separator();
+        file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+             << ",\"args\":{\"name\":";
+        writeJsonString(file, name.c_str());
+        file << "}}";
+    }
+
+    for (const auto& e : events) {
+        if (!e.name) continue;
+        separator();
+        file << "{\"name\":";
+        writeJsonString(file, e.name);
+        file << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.tid
+             << ",\"ts\":" << us(e.start)
+             << ",\"dur\":" << double(e.end - e.start) * 1e-3 << "}";
+    }
+
+    // frame boundaries as instant events across the whole process
+    ProfileRegistry& r = registry();
+    uint64_t count = r.frameCount.load(std::memory_order_acquire);
+    uint64_t back = std::min<uint64_t>(count, PROFILE_FRAME_HISTORY - 1);
+    for (uint64_t i = count - back; i < count; i++) {
+        int64_t t = r.frames[i % PROFILE_FRAME_HISTORY].load(std::memory_order_relaxed);
+        if (t < since || events.empty()) continue;
+        separator();
+        file << "{\"name\":\"frame\",\"ph\":\"i\",\"s\":\"p\",\"pid\":1,\"tid\":0,\"ts\":"
+             << us(t) << "}";
+    }
+
+    file << "\n]}\n";
+    return bool(file);
+}
+
+#endif
@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Frame profiler.
+//
+// PROFILE_ZONE("name") times the rest of the enclosing scope. Every thread
+// records into its own ring of the most recent zones, so recording takes
+// no lock and the rings are only read by whoever asks for stats or a
+// trace. Zone names must be string literals.
+//
+// Configuring with -DTERRAIN_PROFILE=OFF turns the macros into nothing
+// and the functions below into empty inlines.
+
+#ifndef TERRAIN_PROFILE
+#define TERRAIN_PROFILE 1
+#endif
+
+struct ProfileZoneStats {
+    std::string name;
+    uint32_t count;         // calls in the window
+    double p50Ms;
+    double p95Ms;
+    double p99Ms;
+};
+
+#if TERRAIN_PROFILE
+
+int64_t profileNowNs();
+void profileRecord(const char* name, int64_t startNs, int64_t endNs);
+
+// Marks the start of a frame on the calling thread
+void profileFrame();
+
+// Shown in traces, call once from the thread itself
+void profileThreadName(const char* name);
+
+// Percentiles of every zone recorded over the last frames frames, by name
+void profileStats(std::vector<ProfileZoneStats>& out, int frames = 120);
+
+// Writes the last frames frames as Chrome trace-event JSON, viewable in
+// chrome://tracing or Perfetto. Returns false if the file can't be written.
+bool profileExportTrace(const std::string& path, int frames = 300);
+
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name) : m_name(name), m_start(profileNowNs()) {}
+    ~ProfileScope() { profileRecord(m_name, m_start, profileNowNs()); }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* m_name;
+    int64_t m_start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) ProfileScope PROFILE_CONCAT(profileZone_, __LINE__)(name)
+#define PROFILE_FRAME() profileFrame()
+
+#else
+
+inline void profileFrame() {}
+inline void profileThreadName(const char*) {}
+inline void profileStats(std::vector<ProfileZoneStats>& out, int = 120) { out.clear(); }
+inline bool profileExportTrace(const std::string&, int = 300) { return false; }
+
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_FRAME() ((void)0)
+
+#endif
@@ -0,0 +1,152 @@
+#include "mappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#ifdef _WIN32
+
+static bool mapWin32(const std::string& path, size_t size, bool writable,
+                     void*& file, void*& mapping, uint8_t*& data, size_t& outSize) {
+    DWORD access = writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ;
+    DWORD create = writable ? OPEN_ALWAYS : OPEN_EXISTING;
+
+    HANDLE f = CreateFileA(path.c_str(), access, FILE_SHARE_READ, nullptr,
+                           create, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (f == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER fileSize;
+    if (writable) {
+        fileSize.QuadPart = (LONGLONG)size;
+        if (!SetFilePointerEx(f, fileSize, nullptr, FILE_BEGIN) || !SetEndOfFile(f)) {
+            CloseHandle(f);
+            return false;
+        }
+    } else if (!GetFileSizeEx(f, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(f);
+        return false;
+    }
+
+    HANDLE m = CreateFileMappingA(f, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY,
+                                  0, 0, nullptr);
+    if (!m) {
+        CloseHandle(f);
+        return false;
+    }
+
+    void* view = MapViewOfFile(m, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(m);
+        CloseHandle(f);
+        return false;
+    }
+
+    file = f;
+    mapping = m;
+    data = static_cast<uint8_t*>(view);
+    outSize = (size_t)fileSize.QuadPart;
+    return true;
+}
+
+bool MappedFile::openRead(const std::string& path) {
+    close();
+    m_writable = false;
+    return mapWin32(path, 0, false, m_file, m_mapping, m_data, m_size);
+}
+
+bool MappedFile::openReadWrite(const std::string& path, size_t size) {
+    close();
+    m_writable = true;
+    return mapWin32(path, size, true, m_file, m_mapping, m_data, m_size);
+}
+
+void MappedFile::close() {
+    if (m_data) UnmapViewOfFile(m_data);
+    if (m_mapping) CloseHandle(m_mapping);
+    if (m_file) CloseHandle(m_file);
+    m_data = nullptr;
+    m_mapping = nullptr;
+    m_file = nullptr;
+    m_size = 0;
+}
+
+void MappedFile::flush() {
+    if (m_data && m_writable) FlushViewOfFile(m_data, 0);
+}
+
+#else
+
+bool MappedFile::openRead(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        ::close(fd);
+        return false;
+    }
+
+    m_fd = fd;
+    m_data = static_cast<uint8_t*>(p);
+    m_size = (size_t)st.st_size;
+    m_writable = false;
+    return true;
+}
+
+bool MappedFile::openReadWrite(const std::string& path, size_t size) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return false;
+
+    // growing with ftruncate leaves a sparse file, untouched tiles cost no disk
+    if (ftruncate(fd, (off_t)size) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        ::close(fd);
+        return false;
+    }
+
+    m_fd = fd;
+    m_data = static_cast<uint8_t*>(p);
+    m_size = size;
+    m_writable = true;
+    return true;
+}
+
+void MappedFile::close() {
+    if (m_data) munmap(m_data, m_size);
+    if (m_fd >= 0) ::close(m_fd);
+    m_data = nullptr;
+    m_size = 0;
+    m_fd = -1;
+}
+
+void MappedFile::flush() {
+    if (m_data && m_writable) msync(m_data, m_size, MS_ASYNC);
+}
+
+#endif
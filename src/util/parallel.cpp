@@ -0,0 +1,169 @@
+#include "parallel.h"
+#include "log.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using BlockFn = std::function<void(size_t, size_t)>;
+
+// set while a thread is running blocks, nested loops then run inline
+static thread_local bool t_inLoop = false;
+
+static void runInline(size_t count, size_t grain, const BlockFn& fn) {
+    for (size_t begin = 0; begin < count; begin += grain) {
+        fn(begin, std::min(count, begin + grain));
+    }
+}
+
+class ParallelPool {
+public:
+    ~ParallelPool() { stop(); }
+
+    void run(size_t count, size_t grain, const BlockFn& fn) {
+        // one loop at a time, a second caller does its own work instead
+        // of queueing behind the first
+        std::unique_lock<std::mutex> loopLock(m_loopMutex, std::try_to_lock);
+        size_t blocks = (count + grain - 1) / grain;
+        if (!loopLock.owns_lock() || blocks <= 1) {
+            runInline(count, grain, fn);
+            return;
+        }
+
+        if (!m_started) start(0);
+        if (m_workers.empty()) {
+            runInline(count, grain, fn);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_fn = &fn;
+            m_count = count;
+            m_grain = grain;
+            m_blocks = blocks;
+            m_next.store(0, std::memory_order_relaxed);
+            m_generation++;
+        }
+        m_wake.notify_all();
+
+        t_inLoop = true;
+        runBlocks();
+        t_inLoop = false;
+
+        // workers still finishing a block hold a pointer to fn
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [&] { return m_active == 0; });
+        m_fn = nullptr;
+    }
+
+    void resize(unsigned count) {
+        std::lock_guard<std::mutex> loopLock(m_loopMutex);
+        stop();
+        start(count);
+    }
+
+    unsigned threads() {
+        std::lock_guard<std::mutex> loopLock(m_loopMutex);
+        if (!m_started) start(0);
+        return unsigned(m_workers.size()) + 1;
+    }
+
+private:
+    void runBlocks() {
+        size_t block;
+        while ((block = m_next.fetch_add(1, std::memory_order_relaxed)) < m_blocks) {
+            size_t begin = block * m_grain;
+            (*m_fn)(begin, std::min(m_count, begin + m_grain));
+        }
+    }
+
+    void start(unsigned count) {
+        if (count == 0) count = std::max(1u, std::thread::hardware_concurrency());
+
+        // the calling thread is the last participant
+        m_stop = false;
+        for (unsigned i = 1; i < count; i++) {
+            m_workers.emplace_back(&ParallelPool::workerLoop, this);
+        }
+        m_started = true;
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for (auto& t : m_workers) {
+            t.join();
+        }
+        m_workers.clear();
+        m_started = false;
+    }
+
+    void workerLoop() {
+        t_inLoop = true;
+        profileThreadName("pool worker");
+        uint64_t seen = 0;
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;) {
+            m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+            if (m_stop) return;
+            seen = m_generation;
+
+            // woke after the loop was already finished
+            if (!m_fn) continue;
+
+            m_active++;
+            lock.unlock();
+            runBlocks();
+            lock.lock();
+            if (--m_active == 0) m_done.notify_all();
+        }
+    }
+
+    std::mutex m_loopMutex;
+    std::vector<std::thread> m_workers;
+    bool m_started = false;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    bool m_stop = false;
+    uint64_t m_generation = 0;
+    int m_active = 0;
+
+    // the loop being run
+    const BlockFn* m_fn = nullptr;
+    size_t m_count = 0;
+    size_t m_grain = 1;
+    size_t m_blocks = 0;
+    std::atomic<size_t> m_next{ 0 };
+};
+
+static ParallelPool& pool() {
+    static ParallelPool instance;
+    return instance;
+}
+
+void parallelFor(size_t count, size_t grain, const BlockFn& fn) {
+    grain = std::max<size_t>(grain, 1);
+    if (t_inLoop) {
+        runInline(count, grain, fn);
+        return;
+    }
+    pool().run(count, grain, fn);
+}
+
+void setParallelThreads(unsigned count) {
+    pool().resize(count);
+}
+
+unsigned parallelThreads() {
+    return pool().threads();
+}
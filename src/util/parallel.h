@@ -0,0 +1,17 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+
+// A process-wide pool of worker threads for data-parallel loops.
+//
+// parallelFor splits [0, count) into blocks of grain items and hands them
+// to the pool, the calling thread takes blocks too. Block boundaries only
+// depend on count and grain, never on the thread count, so a loop whose
+// blocks write disjoint output gives identical results on any machine.
+// Calls made from inside a block run inline.
+void parallelFor(size_t count, size_t grain,
+                 const std::function<void(size_t begin, size_t end)>& fn);
+
+// 0 picks hardware_concurrency. Resizing waits for running loops.
+void setParallelThreads(unsigned count);
+unsigned parallelThreads();
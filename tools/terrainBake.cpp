@@ -0,0 +1,155 @@
+// terrain_bake: generates a rectangle of chunks ahead of time and stores
+// them in a tile pack the viewer reads instead of running the noise.
+// Links only the GL-free terrain core.
+//
+//   terrain_bake [--out terrain_cache.pack] [--seed N] [--radius R]
+//                [--region x0,z0,x1,z1] [--max-level N] [--noise-scale F]
+//                [--octaves N] [--mix F] [--threads N]
+//
+// The pack is only valid for the generator parameters it was baked with,
+// start the viewer with the same --seed, --noise-scale, --octaves and --mix.
+
+#include "terrain/chunkGen.h"
+#include "terrain/chunkLod.h"
+#include "terrain/const.h"
+#include "terrain/tilePack.h"
+#include "util/parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct BakeOptions {
+    std::string outPath = "terrain_cache.pack";
+    GeneratorParams params;
+    ChunkCoord min{ -16, -16 };     // inclusive
+    ChunkCoord max{ 16, 16 };
+    int maxLevel = MAX_CHUNK_LOD;
+    unsigned threads = 0;           // 0 is every hardware thread
+};
+
+// slots left free for chunks the viewer generates outside the region,
+// they cost no disk space until used
+constexpr uint32_t BAKE_SPARE_SLOTS = 16384;
+
+static void usage() {
+    std::cerr << "usage: terrain_bake [--out file] [--seed N] [--radius R]\n"
+                 "                    [--region x0,z0,x1,z1] [--max-level N]\n"
+                 "                    [--noise-scale F] [--octaves N] [--mix F] [--threads N]\n";
+}
+
+int main(int argc, char** argv) {
+    BakeOptions opt;
+
+    for (int i = 1; i < argc; i++) {
+        auto arg = [&](const char* name) {
+            return std::strcmp(argv[i], name) == 0 && i + 1 < argc;
+        };
+
+        if (arg("--out")) {
+            opt.outPath = argv[++i];
+        } else if (arg("--seed")) {
+            opt.params.seed = std::atoi(argv[++i]);
+        } else if (arg("--radius")) {
+            int r = std::max(0, std::atoi(argv[++i]));
+            opt.min = { -r, -r };
+            opt.max = { r, r };
+        } else if (arg("--region")) {
+            if (std::sscanf(argv[++i], "%d,%d,%d,%d",
+                            &opt.min.x, &opt.min.z, &opt.max.x, &opt.max.z) != 4) {
+                usage();
+                return 1;
+            }
+        } else if (arg("--max-level")) {
+            opt.maxLevel = std::clamp(std::atoi(argv[++i]), 0, MAX_CHUNK_LOD);
+        } else if (arg("--noise-scale")) {
+            opt.params.noiseScale = float(std::atof(argv[++i]));
+        } else if (arg("--octaves")) {
+            opt.params.octaves = std::max(1, std::atoi(argv[++i]));
+        } else if (arg("--mix")) {
+            opt.params.mixRatio = float(std::atof(argv[++i]));
+        } else if (arg("--threads")) {
+            opt.threads = unsigned(std::max(0, std::atoi(argv[++i])));
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    if (opt.max.x < opt.min.x || opt.max.z < opt.min.z) {
+        std::cerr << "empty region\n";
+        return 1;
+    }
+
+    std::vector<ChunkCoord> coords;
+    for (int z = opt.min.z; z <= opt.max.z; z++) {
+        for (int x = opt.min.x; x <= opt.max.x; x++) {
+            coords.push_back({ x, z });
+        }
+    }
+
+    // every level the viewer may ask for, coarse ones are cheap
+    const int levels = opt.maxLevel + 1;
+    const size_t tiles = coords.size() * size_t(levels);
+    if (tiles + BAKE_SPARE_SLOTS > UINT32_MAX / 2) {
+        std::cerr << "region too large for one pack\n";
+        return 1;
+    }
+
+    // start from an empty pack so its size fits this region
+    std::error_code ec;
+    std::filesystem::remove(opt.outPath, ec);
+
+    uint64_t hash = generatorHash(opt.params);
+    TilePack pack;
+    if (!pack.open(opt.outPath, hash, uint32_t(tiles) + BAKE_SPARE_SLOTS)) {
+        return 1;
+    }
+
+    setParallelThreads(opt.threads);
+    std::cout << "baking " << coords.size() << " chunks x " << levels << " levels, seed "
+              << opt.params.seed << ", " << parallelThreads() << " threads\n";
+
+    using clock = std::chrono::steady_clock;
+    auto t0 = clock::now();
+
+    std::atomic<uint64_t> tileBytes{ 0 };
+
+    parallelFor(coords.size(), 4, [&](size_t begin, size_t end) {
+        std::vector<float> heights(size_t(CHUNK_VERTS) * CHUNK_VERTS);
+        std::vector<float> gradients(2 * heights.size());
+        uint64_t bytes = 0;
+
+        for (size_t i = begin; i < end; i++) {
+            for (int level = 0; level < levels; level++) {
+                HeightRange range = generateChunkHeightmap(heights.data(), gradients.data(),
+                    coords[i], opt.params, level);
+                pack.write(coords[i], level, hash, heights.data(), gradients.data(), range);
+
+                int n = chunkLodVerts(level);
+                bytes += 3 * sizeof(float) * size_t(n) * n;
+            }
+        }
+        tileBytes += bytes;
+    });
+
+    pack.close();
+    double seconds = std::chrono::duration<double>(clock::now() - t0).count();
+
+    uintmax_t fileBytes = std::filesystem::file_size(opt.outPath, ec);
+    if (ec) fileBytes = 0;
+
+    std::cout << "wrote " << tiles << " tiles to " << opt.outPath << " in " << seconds << " s\n"
+              << "  " << double(coords.size()) / seconds << " chunks/s, "
+              << double(tiles) / seconds << " tiles/s\n"
+              << "  " << tileBytes.load() << " bytes of tile data, "
+              << fileBytes << " bytes file size (sparse past the used slots)\n";
+    return 0;
+}
@@ -0,0 +1,425 @@
+// terrain_bench: headless throughput benchmark for the terrain generation
+// hot paths. Links only the GL-free terrain core.
+//
+//   terrain_bench [--iterations N] [--sizes 256,512] [--seeds 1337,42]
+//                 [--simd scalar|sse4.1|avx2] [--threads 1,4,16]
+//                 [--json out.json|-]
+//
+// heightmap_cpu and mesh_cpu run once per --threads entry to show how
+// they scale across the worker pool. The fbm and chunk cases are serial,
+// one chunk per call the way a streaming worker runs them.
+
+#include "terrain/const.h"
+#include "terrain/chunkGen.h"
+#include "terrain/heightmap.h"
+#include "terrain/mesh.h"
+#include "terrain/noise.h"
+#include "util/parallel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct BenchResult {
+    std::string name;
+    int size;
+    int seed;
+    int threads;
+    long long items;        // samples or vertices per iteration
+    std::string unit;
+    double minMs;
+    double medianMs;
+    double meanMs;
+    double checksum;
+};
+
+struct BenchOptions {
+    int iterations = 10;
+    std::vector<int> sizes{ 256, 512, 1024 };
+    std::vector<int> seeds{ 1337, 12348970 };
+    std::vector<int> threads{ 0 };      // 0 is every hardware thread
+    std::string jsonPath;
+};
+
+static std::vector<int> parseList(const char* s) {
+    std::vector<int> out;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) out.push_back(std::atoi(item.c_str()));
+    }
+    return out;
+}
+
+static void usage() {
+    std::cerr << "usage: terrain_bench [--iterations N] [--sizes a,b,..] [--seeds a,b,..]\n"
+                 "                     [--simd scalar|sse4.1|avx2] [--threads a,b,..]\n"
+                 "                     [--json file|-]\n";
+}
+
+// Runs fn iterations times and returns per-iteration milliseconds
+template <typename Fn>
+static std::vector<double> timeIterations(int iterations, Fn&& fn) {
+    using clock = std::chrono::steady_clock;
+
+    // one untimed warm-up pass to fault in buffers
+    fn();
+
+    std::vector<double> ms;
+    ms.reserve(iterations);
+    for (int i = 0; i < iterations; i++) {
+        auto t0 = clock::now();
+        fn();
+        auto t1 = clock::now();
+        ms.push_back(std::chrono::duration<double, std::milli>(t1 - t0).count());
+    }
+    return ms;
+}
+
+// threads is how many the case actually ran on
+static BenchResult summarize(const std::string& name, int size, int seed, int threads,
+                             long long items, const std::string& unit,
+                             std::vector<double> ms, double checksum) {
+    std::sort(ms.begin(), ms.end());
+    double sum = 0.0;
+    for (double m : ms) sum += m;
+
+    BenchResult r;
+    r.name = name;
+    r.size = size;
+    r.seed = seed;
+    r.threads = threads;
+    r.items = items;
+    r.unit = unit;
+    r.minMs = ms.front();
+    r.medianMs = ms[ms.size() / 2];
+    r.meanMs = sum / double(ms.size());
+    r.checksum = checksum;
+    return r;
+}
+
+static double throughput(const BenchResult& r) {
+    return r.medianMs > 0.0 ? double(r.items) / (r.medianMs / 1000.0) : 0.0;
+}
+
+static double sumOf(const float* v, size_t n) {
+    double s = 0.0;
+    for (size_t i = 0; i < n; i++) s += v[i];
+    return s;
+}
+
+// Weighs every value by its position. Central differences telescope,
+// their plain sum only depends on the chunk edges.
+static double weightedSumOf(const float* v, size_t n) {
+    double s = 0.0;
+    for (size_t i = 0; i < n; i++) s += double(v[i]) * double(i % 61 + 1);
+    return s;
+}
+
+static void benchHeightmapCPU(const BenchOptions& opt, int size, int seed,
+                              std::vector<BenchResult>& out) {
+    std::vector<float> heightmap(size_t(size) * size);
+
+    auto ms = timeIterations(opt.iterations, [&] {
+        generateHeightmapCPU(heightmap.data(), size, size, 100.0f, seed, 0.6f);
+    });
+
+    out.push_back(summarize("heightmap_cpu", size, seed, int(parallelThreads()),
+        (long long)size * size, "samples", ms, sumOf(heightmap.data(), heightmap.size())));
+}
+
+// Point-wise fBm, compile-time octave count against the runtime loop.
+// The octave count goes through a volatile so the runtime version can't
+// be specialised behind our back.
+static void benchFbm(const BenchOptions& opt, int size, int seed,
+                     std::vector<BenchResult>& out) {
+    std::vector<float> values(size_t(size) * size);
+    volatile int runtimeOctaves = 4;
+
+    auto fill = [&](auto&& noise) {
+        for (int y = 0; y < size; y++) {
+            for (int x = 0; x < size; x++) {
+                values[size_t(y) * size + x] = noise(float(x) * 0.01f, float(y) * 0.01f);
+            }
+        }
+    };
+
+    auto specialized = timeIterations(opt.iterations, [&] {
+        fill([&](float x, float y) { return fbm<4>(x, y, seed); });
+    });
+    double specializedSum = sumOf(values.data(), values.size());
+
+    auto runtime = timeIterations(opt.iterations, [&] {
+        int octaves = runtimeOctaves;
+        fill([&](float x, float y) { return fbm(x, y, seed, octaves); });
+    });
+
+    out.push_back(summarize("fbm_specialized", size, seed, 1, (long long)values.size(),
+        "samples", specialized, specializedSum));
+    out.push_back(summarize("fbm_runtime", size, seed, 1, (long long)values.size(),
+        "samples", runtime, sumOf(values.data(), values.size())));
+}
+
+static void benchMeshCPU(const BenchOptions& opt, int size, int seed,
+                         std::vector<BenchResult>& out) {
+    size_t n = size_t(size) * size;
+    std::vector<float> heightmap(n);
+    std::vector<MeshVertex> vertices(n);
+
+    generateHeightmapCPU(heightmap.data(), size, size, 100.0f, seed, 0.6f);
+
+    auto ms = timeIterations(opt.iterations, [&] {
+        generateMeshFromHeightmapCPU(heightmap.data(), vertices.data(),
+            size, size, 1.0f, 1.0f, 100.0f);
+    });
+
+    double checksum = double(vertices[n / 2].position.y) + double(vertices[n / 2].normal.y);
+    out.push_back(summarize("mesh_cpu", size, seed, int(parallelThreads()), (long long)n,
+        "vertices", ms, checksum));
+}
+
+// The chunk cases cover the same area as a size x size grid
+static std::vector<ChunkCoord> chunkSquare(int size) {
+    int perSide = std::max(1, size / CHUNK_SIZE);
+    std::vector<ChunkCoord> coords;
+    for (int z = 0; z < perSide; z++) {
+        for (int x = 0; x < perSide; x++) {
+            coords.push_back({ x - perSide / 2, z - perSide / 2 });
+        }
+    }
+    return coords;
+}
+
+static void benchChunkHeightmap(const BenchOptions& opt, int size, int seed,
+                                std::vector<BenchResult>& out) {
+    auto coords = chunkSquare(size);
+    const size_t perChunk = size_t(CHUNK_VERTS) * CHUNK_VERTS;
+    std::vector<float> heightmaps(coords.size() * perChunk);
+    std::vector<float> gradients(coords.size() * 2 * perChunk);
+    GeneratorParams params;
+    params.seed = seed;
+
+    auto ms = timeIterations(opt.iterations, [&] {
+        for (size_t i = 0; i < coords.size(); i++) {
+            generateChunkHeightmap(&heightmaps[i * perChunk], nullptr, coords[i], params, 0);
+        }
+    });
+
+    out.push_back(summarize("chunk_heightmap", size, seed, 1,
+        (long long)(coords.size() * perChunk), "samples", ms,
+        sumOf(heightmaps.data(), heightmaps.size())));
+
+    // what the streamer runs: heights plus the gradients for normals
+    ms = timeIterations(opt.iterations, [&] {
+        for (size_t i = 0; i < coords.size(); i++) {
+            generateChunkHeightmap(&heightmaps[i * perChunk], &gradients[i * 2 * perChunk],
+                coords[i], params, 0);
+        }
+    });
+
+    out.push_back(summarize("chunk_heightmap_grad", size, seed, 1,
+        (long long)(coords.size() * perChunk), "samples", ms,
+        weightedSumOf(gradients.data(), gradients.size())));
+
+    // the same with Voronoi blended in, feature points cached per chunk
+    params.mixRatio = 0.6f;
+    ms = timeIterations(opt.iterations, [&] {
+        for (size_t i = 0; i < coords.size(); i++) {
+            generateChunkHeightmap(&heightmaps[i * perChunk], &gradients[i * 2 * perChunk],
+                coords[i], params, 0);
+        }
+    });
+
+    out.push_back(summarize("chunk_heightmap_voronoi", size, seed, 1,
+        (long long)(coords.size() * perChunk), "samples", ms,
+        weightedSumOf(gradients.data(), gradients.size())));
+}
+
+static void benchChunkMesh(const BenchOptions& opt, int size, int seed,
+                           std::vector<BenchResult>& out) {
+    auto coords = chunkSquare(size);
+    const size_t perChunk = size_t(CHUNK_VERTS) * CHUNK_VERTS;
+    std::vector<float> heightmaps(coords.size() * perChunk);
+    std::vector<float> gradients(coords.size() * 2 * perChunk);
+    GeneratorParams params;
+    params.seed = seed;
+    for (size_t i = 0; i < coords.size(); i++) {
+        generateChunkHeightmap(&heightmaps[i * perChunk], &gradients[i * 2 * perChunk],
+            coords[i], params, 0);
+    }
+
+    // indices are shared by all chunks and built once, only vertices are per chunk
+    std::vector<ChunkVertex> vertices(perChunk);
+    double checksum = 0.0;
+
+    auto ms = timeIterations(opt.iterations, [&] {
+        checksum = 0.0;
+        for (size_t i = 0; i < coords.size(); i++) {
+            buildChunkVertices(vertices.data(), &heightmaps[i * perChunk],
+                &gradients[i * 2 * perChunk], ChunkLod{});
+            checksum += vertices[perChunk / 2].height;
+        }
+    });
+
+    out.push_back(summarize("chunk_mesh", size, seed, 1,
+        (long long)(coords.size() * perChunk), "vertices", ms, checksum));
+}
+
+struct IndexStats {
+    size_t indexCount;
+    size_t bytes;
+    double acmr;            // vertex shader runs per triangle
+};
+
+// Simulates a FIFO post-transform cache over the shared chunk strips
+static IndexStats chunkIndexStats(int cacheSize) {
+    std::vector<uint16_t> indices;
+    buildChunkIndices(indices, CHUNK_VERTS);
+
+    std::vector<int> fifo;
+    size_t misses = 0;
+    size_t triangles = 0;
+    size_t stripLength = 0;
+
+    for (uint16_t idx : indices) {
+        if (idx == CHUNK_RESTART_INDEX) {
+            stripLength = 0;
+            continue;
+        }
+        if (++stripLength >= 3) triangles++;
+
+        if (std::find(fifo.begin(), fifo.end(), idx) == fifo.end()) {
+            misses++;
+            fifo.push_back(idx);
+            if ((int)fifo.size() > cacheSize) fifo.erase(fifo.begin());
+        }
+    }
+
+    return { indices.size(), indices.size() * sizeof(uint16_t),
+             triangles ? double(misses) / double(triangles) : 0.0 };
+}
+
+static void writeJson(std::ostream& os, const BenchOptions& opt,
+                      const std::vector<BenchResult>& results) {
+    IndexStats stats = chunkIndexStats(32);
+
+    os << "{\n";
+    os << "  \"benchmark\": \"terrain_bench\",\n";
+    os << "  \"noise_simd\": \"" << noiseSimdName(noiseSimd()) << "\",\n";
+    os << "  \"iterations\": " << opt.iterations << ",\n";
+    os << "  \"chunk_indices\": {\"count\": " << stats.indexCount
+       << ", \"bytes\": " << stats.bytes
+       << ", \"acmr_fifo32\": " << stats.acmr << "},\n";
+    os << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto& r = results[i];
+        os << "    {\"name\": \"" << r.name << "\""
+           << ", \"size\": " << r.size
+           << ", \"seed\": " << r.seed
+           << ", \"threads\": " << r.threads
+           << ", \"items\": " << r.items
+           << ", \"unit\": \"" << r.unit << "\""
+           << ", \"min_ms\": " << r.minMs
+           << ", \"median_ms\": " << r.medianMs
+           << ", \"mean_ms\": " << r.meanMs
+           << ", \"throughput\": " << throughput(r)
+           << ", \"checksum\": " << r.checksum
+           << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    os << "  ]\n";
+    os << "}\n";
+}
+
+int main(int argc, char** argv) {
+    BenchOptions opt;
+
+    for (int i = 1; i < argc; i++) {
+        auto arg = [&](const char* name) {
+            return std::strcmp(argv[i], name) == 0 && i + 1 < argc;
+        };
+
+        if (arg("--iterations")) {
+            opt.iterations = std::max(1, std::atoi(argv[++i]));
+        } else if (arg("--sizes")) {
+            opt.sizes = parseList(argv[++i]);
+        } else if (arg("--seeds")) {
+            opt.seeds = parseList(argv[++i]);
+        } else if (arg("--json")) {
+            opt.jsonPath = argv[++i];
+        } else if (arg("--threads")) {
+            opt.threads = parseList(argv[++i]);
+            if (opt.threads.empty()) { usage(); return 1; }
+        } else if (arg("--simd")) {
+            std::string level = argv[++i];
+            if (level == "scalar") setNoiseSimd(NoiseSimd::Scalar);
+            else if (level == "sse4.1") setNoiseSimd(NoiseSimd::SSE41);
+            else if (level == "avx2") setNoiseSimd(NoiseSimd::AVX2);
+            else { usage(); return 1; }
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    std::vector<BenchResult> results;
+    for (int size : opt.sizes) {
+        for (int seed : opt.seeds) {
+            benchFbm(opt, size, seed, results);
+            for (int threads : opt.threads) {
+                setParallelThreads(unsigned(std::max(0, threads)));
+                benchHeightmapCPU(opt, size, seed, results);
+                benchMeshCPU(opt, size, seed, results);
+            }
+            setParallelThreads(0);
+            benchChunkHeightmap(opt, size, seed, results);
+            benchChunkMesh(opt, size, seed, results);
+        }
+    }
+
+    // JSON on stdout keeps stdout parseable, the summary moves to stderr
+    std::ostream& report = opt.jsonPath == "-" ? std::cerr : std::cout;
+    report << "noise kernel: " << noiseSimdName(noiseSimd())
+           << ", iterations: " << opt.iterations << "\n";
+    IndexStats stats = chunkIndexStats(32);
+    report << "chunk indices: " << stats.indexCount << " (" << stats.bytes
+           << " bytes shared), ACMR fifo32=" << stats.acmr << "\n";
+    for (const auto& r : results) {
+        report << r.name << " size=" << r.size << " seed=" << r.seed
+               << " threads=" << r.threads
+               << " median=" << r.medianMs << "ms "
+               << throughput(r) / 1e6 << " M" << r.unit << "/s";
+
+        // scaling against the first thread count measured for this case
+        const BenchResult* base = &r;
+        for (const auto& b : results) {
+            if (b.name == r.name && b.size == r.size && b.seed == r.seed) {
+                base = &b;
+                break;
+            }
+        }
+        if (base != &r) {
+            report << " speedup=" << base->medianMs / r.medianMs << "x";
+            if (base->checksum != r.checksum) report << " CHECKSUM MISMATCH";
+        }
+        report << "\n";
+    }
+
+    if (opt.jsonPath == "-") {
+        writeJson(std::cout, opt, results);
+    } else if (!opt.jsonPath.empty()) {
+        std::ofstream file(opt.jsonPath);
+        if (!file) {
+            std::cerr << "failed to open " << opt.jsonPath << "\n";
+            return 1;
+        }
+        writeJson(file, opt, results);
+    }
+
+    return 0;
+}
@@ -0,0 +1,348 @@
+// terrain_sim: flies a camera along a recorded or synthetic path and runs
+// TerrainManager::update() every frame on a null GPU backend, to tune the
+// view radius, residency budgets and tile cache without a GPU.
+// Links only the GL-free terrain core.
+//
+//   terrain_sim [--path file] [--rate F] [--synthetic line|circle|pingpong]
+//               [--speed U] [--radius U] [--height U] [--frames N] [--fps F]
+//               [--view-radius R] [--cpu-budget MB] [--gpu-budget MB]
+//               [--hysteresis N] [--prefetch S] [--tile-pack file]
+//               [--seed N] [--noise-scale F] [--octaves N] [--mix F]
+//               [--recent S] [--realtime] [--csv file]
+//
+// By default every frame waits for streaming to catch up, so counts only
+// depend on the path and the settings. --realtime paces frames at --fps
+// instead and shows what a machine of this speed falls behind on.
+
+#include "app/cameraPath.h"
+#include "render/camera.h"
+#include "terrain/const.h"
+#include "terrain/gpuBackend.h"
+#include "terrain/terrainManager.h"
+#include "util/log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+enum class SimPath { Recorded, Line, Circle, PingPong };
+
+struct SimOptions {
+    SimPath path = SimPath::Line;
+    std::string pathFile;
+    float rate = 1.0f;              // recorded frames per simulated frame
+    float speed = 400.0f;           // world units per second, synthetic paths
+    float radius = 6000.0f;         // circle radius, ping-pong half length
+    float height = 400.0f;
+    int frames = 0;                 // 0: the recorded path or 30 s
+    float fps = 60.0f;
+
+    int viewRadius = 16;
+    ResidencyBudget budget;
+    float prefetchSeconds = ScheduleSettings{}.prefetchSeconds;
+    std::string tilePackPath;       // empty runs without a tile cache
+    GeneratorParams params;
+
+    // a chunk built again within this many seconds of its eviction counts
+    // as regenerated
+    float recentSeconds = 10.0f;
+    bool realtime = false;
+    std::string csvPath;
+};
+
+struct SimFrame {
+    glm::vec3 position;
+    int built;                      // uploads, new chunks and rebuilds
+    int added;                      // coordinates that weren't resident
+    int evicted;
+    int regenerated;                // added within recentSeconds of eviction
+    size_t resident;
+    size_t cpuBytes;
+    size_t gpuBytes;
+    double updateMs;                // main thread, summed over the frame
+    double buildMs;                 // worker heightmap and mesh time of chunks finished
+    int pending;                    // wanted but not uploaded yet
+};
+
+static void usage() {
+    std::cerr << "usage: terrain_sim [--path file] [--rate F]\n"
+                 "                   [--synthetic line|circle|pingpong] [--speed U] [--radius U]\n"
+                 "                   [--height U] [--frames N] [--fps F] [--view-radius R]\n"
+                 "                   [--cpu-budget MB] [--gpu-budget MB] [--hysteresis N]\n"
+                 "                   [--prefetch S] [--tile-pack file] [--seed N]\n"
+                 "                   [--noise-scale F] [--octaves N] [--mix F] [--recent S]\n"
+                 "                   [--realtime] [--csv file]\n";
+}
+
+// Camera pose at simulated time t for the synthetic paths
+static CameraKey syntheticPose(const SimOptions& opt, float t) {
+    float d = opt.speed * t;
+
+    switch (opt.path) {
+    case SimPath::Circle: {
+        // counter-clockwise seen from above, looking along the tangent
+        float a = d / std::max(opt.radius, 1.0f);
+        glm::vec3 pos(opt.radius * std::cos(a), opt.height, opt.radius * std::sin(a));
+        return { 0, pos, glm::degrees(a) + 90.0f, -15.0f };
+    }
+    case SimPath::PingPong: {
+        // out to +radius and back through the origin to -radius, turning
+        // around at each end
+        float span = 4.0f * std::max(opt.radius, 1.0f);
+        float u = std::fmod(d + opt.radius, span);
+        bool back = u > span * 0.5f;
+        float x = back ? 3.0f * opt.radius - u : u - opt.radius;
+        return { 0, glm::vec3(x, opt.height, 0.0f), back ? 180.0f : 0.0f, -15.0f };
+    }
+    default:
+        return { 0, glm::vec3(d, opt.height, 0.0f), 0.0f, -15.0f };
+    }
+}
+
+int main(int argc, char** argv) {
+    SimOptions opt;
+
+    for (int i = 1; i < argc; i++) {
+        auto arg = [&](const char* name) {
+            return std::strcmp(argv[i], name) == 0 && i + 1 < argc;
+        };
+
+        if (std::strcmp(argv[i], "--realtime") == 0) {
+            opt.realtime = true;
+        } else if (arg("--path")) {
+            opt.path = SimPath::Recorded;
+            opt.pathFile = argv[++i];
+        } else if (arg("--rate")) {
+            opt.rate = std::max(0.01f, float(std::atof(argv[++i])));
+        } else if (arg("--synthetic")) {
+            std::string kind = argv[++i];
+            if (kind == "line") opt.path = SimPath::Line;
+            else if (kind == "circle") opt.path = SimPath::Circle;
+            else if (kind == "pingpong") opt.path = SimPath::PingPong;
+            else { usage(); return 1; }
+        } else if (arg("--speed")) {
+            opt.speed = float(std::atof(argv[++i]));
+        } else if (arg("--radius")) {
+            opt.radius = float(std::atof(argv[++i]));
+        } else if (arg("--height")) {
+            opt.height = float(std::atof(argv[++i]));
+        } else if (arg("--frames")) {
+            opt.frames = std::max(0, std::atoi(argv[++i]));
+        } else if (arg("--fps")) {
+            opt.fps = std::max(1.0f, float(std::atof(argv[++i])));
+        } else if (arg("--view-radius")) {
+            opt.viewRadius = std::max(0, std::atoi(argv[++i]));
+        } else if (arg("--cpu-budget")) {
+            opt.budget.cpuBytes = size_t(std::max(0, std::atoi(argv[++i]))) << 20;
+        } else if (arg("--gpu-budget")) {
+            opt.budget.gpuBytes = size_t(std::max(0, std::atoi(argv[++i]))) << 20;
+        } else if (arg("--hysteresis")) {
+            opt.budget.hysteresis = std::max(0, std::atoi(argv[++i]));
+        } else if (arg("--prefetch")) {
+            opt.prefetchSeconds = std::max(0.0f, float(std::atof(argv[++i])));
+        } else if (arg("--tile-pack")) {
+            opt.tilePackPath = argv[++i];
+        } else if (arg("--seed")) {
+            opt.params.seed = std::atoi(argv[++i]);
+        } else if (arg("--noise-scale")) {
+            opt.params.noiseScale = float(std::atof(argv[++i]));
+        } else if (arg("--octaves")) {
+            opt.params.octaves = std::max(1, std::atoi(argv[++i]));
+        } else if (arg("--mix")) {
+            opt.params.mixRatio = float(std::atof(argv[++i]));
+        } else if (arg("--recent")) {
+            opt.recentSeconds = float(std::atof(argv[++i]));
+        } else if (arg("--csv")) {
+            opt.csvPath = argv[++i];
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    CameraPath recorded;
+    int frames = opt.frames;
+    if (opt.path == SimPath::Recorded) {
+        if (!recorded.load(opt.pathFile)) return 1;
+        if (frames == 0) frames = int(float(recorded.lastFrame()) / opt.rate) + 1;
+    } else if (frames == 0) {
+        frames = int(30.0f * opt.fps);
+    }
+
+    auto gpu = std::make_unique<NullGpuBackend>();
+    const NullGpuBackend& gpuStats = *gpu;
+
+    TerrainManager terrain(std::move(gpu));
+    terrain.viewRadius = opt.viewRadius;
+    terrain.residency.budget = opt.budget;
+    terrain.schedule.prefetchSeconds = opt.prefetchSeconds;
+    terrain.m_params = opt.params;
+    if (!opt.tilePackPath.empty() && !terrain.openTileCache(opt.tilePackPath)) {
+        std::cerr << "tile cache disabled\n";
+    }
+
+    float farPlane = float(opt.viewRadius + 1) * CHUNK_SIZE * CELL_SIZE;
+    Camera camera(60.0f, 16.0f / 9.0f, 1.0f, farPlane);
+
+    profileThreadName("main");
+    std::cout << "simulating " << frames << " frames at " << opt.fps << " fps, view radius "
+              << opt.viewRadius << ", " << (opt.realtime ? "real time" : "settled") << "\n";
+
+    using clock = std::chrono::steady_clock;
+    auto ms = [](clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); };
+    const auto frameTime = std::chrono::duration<double>(1.0 / opt.fps);
+    const int recentFrames = int(opt.recentSeconds * opt.fps);
+
+    std::vector<SimFrame> samples;
+    samples.reserve(frames);
+
+    // chunks resident after the previous frame, and when coordinates were
+    // last evicted
+    std::unordered_map<ChunkCoord, bool, ChunkCoordHash> previous;
+    std::unordered_map<ChunkCoord, int, ChunkCoordHash> evictedAt;
+
+    auto start = clock::now();
+    for (int frame = 0; frame < frames; frame++) {
+        PROFILE_FRAME();
+
+        float t = float(frame) / opt.fps;
+        CameraKey key = opt.path == SimPath::Recorded
+            ? recorded.at(float(frame) * opt.rate)
+            : syntheticPose(opt, t);
+        camera.setPose(key.position, key.yaw, key.pitch);
+        camera.updateVelocity(1.0f / opt.fps);
+
+        SimFrame s{};
+        s.position = key.position;
+
+        auto step = [&] {
+            auto t0 = clock::now();
+            terrain.update(camera.position(), camera.front(), camera.velocity());
+            s.updateMs += ms(clock::now() - t0);
+            s.built += terrain.scheduleStats.uploads;
+            s.buildMs += terrain.scheduleStats.buildMs;
+        };
+
+        step();
+        if (opt.realtime) {
+            std::this_thread::sleep_until(start + frameTime * (frame + 1));
+        } else {
+            auto settleStart = clock::now();
+            while (!terrain.isIdle() && ms(clock::now() - settleStart) < 10000.0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                step();
+            }
+        }
+
+        for (auto& [cc, seen] : previous) seen = false;
+        for (const auto& [cc, chunk] : terrain.chunks) {
+            auto it = previous.find(cc);
+            if (it != previous.end()) {
+                it->second = true;
+                continue;
+            }
+            s.added++;
+            auto ev = evictedAt.find(cc);
+            if (ev != evictedAt.end() && frame - ev->second <= recentFrames) s.regenerated++;
+        }
+        for (auto it = previous.begin(); it != previous.end();) {
+            if (it->second) {
+                ++it;
+                continue;
+            }
+            s.evicted++;
+            evictedAt[it->first] = frame;
+            it = previous.erase(it);
+        }
+        for (const auto& [cc, chunk] : terrain.chunks) previous.emplace(cc, true);
+
+        const ResidencyStats& res = terrain.residency.stats();
+        s.resident = res.resident;
+        s.cpuBytes = res.cpuBytes;
+        s.gpuBytes = res.gpuBytes;
+        const ScheduleStats& sched = terrain.scheduleStats;
+        s.pending = sched.waiting + sched.inFlight + sched.deferred;
+        samples.push_back(s);
+    }
+    double seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+    if (!opt.csvPath.empty()) {
+        std::ofstream csv(opt.csvPath);
+        if (!csv) {
+            std::cerr << "failed to write " << opt.csvPath << "\n";
+            return 1;
+        }
+        csv << "frame,x,z,built,added,evicted,regenerated,resident,cpu_mb,gpu_mb,update_ms,build_ms,pending\n";
+        for (size_t i = 0; i < samples.size(); i++) {
+            const SimFrame& s = samples[i];
+            csv << i << "," << s.position.x << "," << s.position.z << "," << s.built << ","
+                << s.added << "," << s.evicted << "," << s.regenerated << "," << s.resident << ","
+                << double(s.cpuBytes) / 1048576.0 << "," << double(s.gpuBytes) / 1048576.0 << ","
+                << s.updateMs << "," << s.buildMs << "," << s.pending << "\n";
+        }
+    }
+
+    long long built = 0, added = 0, evicted = 0, regenerated = 0;
+    size_t peakCpu = 0, peakGpu = 0, peakResident = 0;
+    int maxBuilt = 0, maxEvicted = 0, maxPending = 0;
+    size_t worst = 0, worstBuild = 0;
+    for (size_t i = 0; i < samples.size(); i++) {
+        const SimFrame& s = samples[i];
+        built += s.built;
+        added += s.added;
+        evicted += s.evicted;
+        regenerated += s.regenerated;
+        peakCpu = std::max(peakCpu, s.cpuBytes);
+        peakGpu = std::max(peakGpu, s.gpuBytes);
+        peakResident = std::max(peakResident, s.resident);
+        maxBuilt = std::max(maxBuilt, s.built);
+        maxEvicted = std::max(maxEvicted, s.evicted);
+        maxPending = std::max(maxPending, s.pending);
+        if (s.updateMs > samples[worst].updateMs) worst = i;
+        if (s.buildMs > samples[worstBuild].buildMs) worstBuild = i;
+    }
+
+    double n = std::max<double>(1.0, double(samples.size()));
+    const GpuStats& gs = gpuStats.stats();
+    TilePack::Stats cache = terrain.tileCacheStats();
+
+    std::cout << "ran in " << seconds << " s\n"
+              << "  built     " << built << " chunks, " << double(built) / n << " per frame, max "
+              << maxBuilt << "\n"
+              << "  evicted   " << evicted << " chunks, " << double(evicted) / n << " per frame, max "
+              << maxEvicted << "\n"
+              << "  regenerated within " << opt.recentSeconds << " s of eviction: " << regenerated
+              << " of " << added << " new chunks\n"
+              << "  peak resident " << peakResident << " chunks, CPU "
+              << double(peakCpu) / 1048576.0 << " MB, GPU " << double(peakGpu) / 1048576.0
+              << " MB (arena " << double(gs.allocatedBytes) / 1048576.0 << " MB)\n"
+              << "  uploaded " << double(gs.uploadedBytes) / 1048576.0 << " MB in " << gs.uploads
+              << " uploads\n"
+              << "  prefetch  " << terrain.prefetchStats.requested << " requested, "
+              << 100.0f * terrain.prefetchStats.hitRate() << "% of chunks coming into view "
+              << "were resident\n";
+    if (!samples.empty()) {
+        std::cout << "  worst frame " << worst << ": " << samples[worst].updateMs
+                  << " ms main-thread update\n"
+                  << "  worst generation frame " << worstBuild << ": "
+                  << samples[worstBuild].buildMs << " ms heightmap and mesh on workers\n";
+    }
+    if (opt.realtime) {
+        std::cout << "  most chunks still pending in one frame: " << maxPending << "\n";
+    }
+    if (cache.slotCount > 0) {
+        std::cout << "  tile cache " << cache.hits << " hits, " << cache.misses << " misses"
+                  << (terrain.tileCacheCurrent() ? "" : ", the pack holds other parameters")
+                  << "\n";
+    }
+    return 0;
+}